@@ -1,56 +1,1010 @@
-/*
-    AUTHOR:
-        Yat Long Lo
-
-    EMAIL:
-        yllo2@illinois.edu
-
-*/
-
-#include <stdlib.h>
-#include <stdio.h>
-#include <string.h>
-#include <math.h>
-#include <hdf5.h>
-#include <sys/time.h>
-#include "reproject.h"
-#include "io.h"
-
-#define MAX_MODIS_BANDS 38
-
-int main(int argc, char ** argv) {
-	//Input variables
-	char* file_path;
-	char* output_file;
-	char* project_instrument;
-	char* base_instrument; 
-	char* misr_args[3][50];
-	char* modis_args[1][50];
-	char* modis_bands[MAX_MODIS_BANDS][50];
-
-	if(argc < 2){
-		printf("Usage: ./af_run input_parameters.txt\n");
-		return -1;
-	}
-	
-	//Open input parameters file
-	FILE* file = fopen(argv[1], "r");
-	if(file == NULL){
-		printf("Input parameters file does not exist\n");
-		return -1;
-	}
-	//Read in input parameters
-	char line[256];
-	int line_count = 0;
-	while(fgets(line, sizeof(line), file)){
-		char* arg = strchr(line,'=');
-		arg++;
-		char* value = arg;
-		printf("Found value: %s\n", value);
-	}
-	
-	//Close input parameters file
-	fclose(file);
-	return 0;
-
-}
+/*
+    AUTHOR:
+        Yat Long Lo
+
+    EMAIL:
+        yllo2@illinois.edu
+
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <hdf5.h>
+#include <sys/time.h>
+#include "reproject.h"
+#include "io.h"
+#ifdef AF_USE_MPI
+#include <mpi.h>
+#endif
+
+#define MAX_MODIS_BANDS 38
+//Sampling step (in cells, both directions) of the coarse MISR geolocation pass that picks the blocks a rank needs
+#define MISR_GEO_STRIDE 16
+//Default neighbor search radius in meters
+#define DEFAULT_MAX_RADIUS 1000
+//MPI-IO hints given as mpi_info_<key>=<value> parameters
+#define MAX_MPI_HINTS 16
+//Outputs (jobs) of one run over all parameter files
+#define MAX_JOBS 32
+//idwInterpolate defaults: neighbors and distance power
+#define DEFAULT_IDW_K 4
+#define DEFAULT_IDW_POWER 2
+
+//Strips the line ending and trailing blanks of a parameter value
+static void trim_value(char* value){
+	size_t len = strlen(value);
+	while(len > 0 && (value[len - 1] == '\n' || value[len - 1] == '\r' || value[len - 1] == ' ' || value[len - 1] == '\t')){
+		value[--len] = '\0';
+	}
+}
+
+//Contiguous share of n items for one rank: [*first, *first + *count)
+static void split_range(hsize_t n, int rank, int size, hsize_t* first, hsize_t* count){
+	*first = n * rank / size;
+	*count = n * (rank + 1) / size - *first;
+}
+
+//Great circle distance in meters (same earth radius as the reprojection)
+static double geo_distance(double lat1, double lon1, double lat2, double lon2){
+	const double earth_radius = 6367444;
+	double p1 = lat1 * M_PI / 180;
+	double p2 = lat2 * M_PI / 180;
+	double dp = sin((p2 - p1) / 2);
+	double dl = sin((lon2 - lon1) * M_PI / 180 / 2);
+	double h = dp * dp + cos(p1) * cos(p2) * dl * dl;
+	return 2 * earth_radius * asin(sqrt(h < 1 ? h : 1));
+}
+
+static int valid_geo(af_real lat, af_real lon){
+	return lat >= -90 && lat <= 90 && lon >= -180 && lon <= 360;
+}
+
+//Picks the MISR blocks holding sources within max_r of the targets, from a strided read of the block geolocation.
+//A fine cell is at most about one sample spacing from a sample of its block, so a block is kept when one of its
+//samples lies within max_r plus 1.5 sample spacings of a target. Returns the covering range of blocks
+static int misr_block_range(hid_t file, char* resolution, af_real* tar_lat, af_real* tar_lon, int n_tar, double max_r, int* first_block, int* num_blocks){
+	char* location = strcmp(resolution, "H") == 0 ? "HRGeolocation" : "Geolocation";
+	char lat_name[AF_PATH_LEN];
+	char lon_name[AF_PATH_LEN];
+	snprintf(lat_name, AF_PATH_LEN, "/MISR/%s/GeoLatitude", location);
+	snprintf(lon_name, AF_PATH_LEN, "/MISR/%s/GeoLongitude", location);
+	af_dataset_info* info = af_catalog_lookup(file, lat_name);
+	if(info == NULL || info->rank != 3){
+		printf("MISR geolocation not found\n");
+		return -1;
+	}
+	*first_block = 0;
+	*num_blocks = 0;
+	if(n_tar == 0){
+		return 0;
+	}
+
+	hsize_t blocks = info->dims[0];
+	hsize_t offset[3] = {0, 0, 0};
+	hsize_t count[3] = {blocks, (info->dims[1] + MISR_GEO_STRIDE - 1) / MISR_GEO_STRIDE, (info->dims[2] + MISR_GEO_STRIDE - 1) / MISR_GEO_STRIDE};
+	hsize_t stride[3] = {1, MISR_GEO_STRIDE, MISR_GEO_STRIDE};
+	af_real* lat = af_read_hyperslab(file, lat_name, 3, offset, count, stride);
+	af_real* lon = af_read_hyperslab(file, lon_name, 3, offset, count, stride);
+	if(lat == NULL || lon == NULL){
+		free(lat);
+		free(lon);
+		return -1;
+	}
+
+	sphereTree* tree = sphereTreeCreate(tar_lat, tar_lon, n_tar);
+	int rows = count[1];
+	int cols = count[2];
+	int last_block = -1;
+	int b;
+	for(b = 0; b < (int)blocks; b++){
+		af_real* b_lat = &lat[(size_t)b * rows * cols];
+		af_real* b_lon = &lon[(size_t)b * rows * cols];
+		//Largest spacing between neighbouring samples of the block
+		double spacing = 0;
+		int r, c;
+		for(r = 0; r < rows; r++){
+			for(c = 0; c < cols; c++){
+				int i = r * cols + c;
+				if(!valid_geo(b_lat[i], b_lon[i])){
+					continue;
+				}
+				if(c + 1 < cols && valid_geo(b_lat[i + 1], b_lon[i + 1])){
+					double d = geo_distance(b_lat[i], b_lon[i], b_lat[i + 1], b_lon[i + 1]);
+					spacing = d > spacing ? d : spacing;
+				}
+				if(r + 1 < rows && valid_geo(b_lat[i + cols], b_lon[i + cols])){
+					double d = geo_distance(b_lat[i], b_lon[i], b_lat[i + cols], b_lon[i + cols]);
+					spacing = d > spacing ? d : spacing;
+				}
+			}
+		}
+		int i;
+		for(i = 0; i < rows * cols; i++){
+			if(valid_geo(b_lat[i], b_lon[i]) && sphereTreeNearest(tree, b_lat[i], b_lon[i], max_r + 1.5 * spacing) >= 0){
+				if(last_block < 0){
+					*first_block = b;
+				}
+				last_block = b;
+				break;
+			}
+		}
+	}
+	sphereTreeFree(tree);
+	free(lat);
+	free(lon);
+	//Samples holding fill are skipped, so a block whose valid cells near the targets all lie between its samples
+	//could be missed at either end of the range; one more block on each side keeps the selection conservative
+	if(last_block >= 0){
+		*first_block = *first_block > 0 ? *first_block - 1 : 0;
+		last_block = last_block + 1 < (int)blocks ? last_block + 1 : last_block;
+	}
+	*num_blocks = last_block < 0 ? 0 : last_block - *first_block + 1;
+	return 0;
+}
+
+//Output of one rank: the configured file itself when running alone, name_rank<r>.h5 otherwise.
+//Fails rather than truncate, which could drop the rank suffix and make ranks share a file
+static int rank_output_path(char* output_file, int rank, int size, char* path){
+	if(size == 1){
+		snprintf(path, AF_PATH_LEN, "%s", output_file);
+		return 0;
+	}
+	char base[AF_PATH_LEN];
+	snprintf(base, AF_PATH_LEN, "%s", output_file);
+	char* ext = strrchr(base, '.');
+	if(ext != NULL && strcmp(ext, ".h5") == 0){
+		*ext = '\0';
+	}
+	const int max_base = AF_PATH_LEN - (int)strlen("_rank00000.h5") - 1;
+	int len = snprintf(path, AF_PATH_LEN, "%.*s_rank%05d.h5", max_base, base, rank);
+	if(len < 0 || len >= AF_PATH_LEN || strlen(base) > (size_t)max_base){
+		printf("Output path too long for the rank suffix: %s\n", output_file);
+		return -1;
+	}
+	return 0;
+}
+
+//Columns of the swath (width of the first granule holding scan lines and geolocation), known to every rank
+static hsize_t modis_swath_cols(hid_t file, char* resolution, char** granules, int num_granules, hsize_t* granule_rows){
+	int g;
+	for(g = 0; g < num_granules; g++){
+		if(granule_rows[g] > 0){
+			char dataset_name[AF_PATH_LEN];
+			snprintf(dataset_name, AF_PATH_LEN, "/MODIS/%s/%s/Geolocation/Latitude", granules[g], resolution);
+			af_dataset_info* info = af_catalog_lookup(file, dataset_name);
+			if(info != NULL && info->rank == 2){
+				return info->dims[1];
+			}
+		}
+	}
+	return 0;
+}
+
+static int af_run_exit(int status){
+#ifdef AF_USE_MPI
+	MPI_Finalize();
+#endif
+	return status;
+}
+
+//One output of the run, as given in the parameter file, and the shared work it draws on
+typedef struct {
+	char file_path[AF_PATH_LEN];
+	char output_file[AF_PATH_LEN];
+	char project_instrument[50];
+	char base_instrument[50];
+	char method[50];
+	char misr_args[3][50];		//resolution, camera_angle, radiance
+	char modis_res[50];
+	char bands[MAX_MODIS_BANDS][50];
+	int num_bands;
+	double max_r;
+	int k;				//idwInterpolate neighbors
+	double power;			//idwInterpolate distance power
+	//Output layout: scan lines per chunk, deflate level (0 to store uncompressed), encoding of the radiance
+	hsize_t chunk_rows;
+	int deflate_level;
+	af_encoding encoding;
+	double scale_factor;
+	double add_offset;
+	//Plan: indices into the tables of af_plan
+	int group;
+	int mapping;
+	int misr_rad;
+	int modis_bands[MAX_MODIS_BANDS];
+} af_job;
+
+//Settings for the whole run
+typedef struct {
+	int shared_output;
+	char nn_cache[AF_PATH_LEN];	//nearest neighbor mapping cache, one file per rank; empty to always recompute
+	char hint_keys[MAX_MPI_HINTS][50];
+	char hint_values[MAX_MPI_HINTS][50];
+	int num_hints;
+} af_run_options;
+
+//Jobs on the same input file and resolutions share one pass over the swath: the geolocation of both
+//instruments is read once per piece, each neighbor mapping is computed once and each radiance read once
+typedef struct {
+	char* file_path;
+	char* misr_res;
+	char* modis_res;
+	double max_r;			//largest radius of its mappings, for the MISR block selection
+} af_plan_group;
+
+typedef enum {AF_MAP_NN, AF_MAP_KNN} af_mapping_kind;
+
+typedef struct {
+	int group;
+	af_mapping_kind kind;
+	double max_r;
+	int k;
+} af_plan_mapping;
+
+typedef struct {
+	int group;
+	char* camera;
+	char* radiance;
+} af_plan_misr_rad;
+
+typedef struct {
+	int group;
+	char* band;
+	char* dname;
+	int band_index;
+} af_plan_modis_band;
+
+typedef struct {
+	af_plan_group groups[MAX_JOBS];
+	int num_groups;
+	af_plan_mapping mappings[MAX_JOBS];
+	int num_mappings;
+	af_plan_misr_rad misr_rads[MAX_JOBS];
+	int num_misr_rads;
+	af_plan_modis_band modis_bands[MAX_JOBS * MAX_MODIS_BANDS];
+	int num_modis_bands;
+} af_plan;
+
+static void default_job(af_job* job){
+	memset(job, 0, sizeof(af_job));
+	snprintf(job->method, 50, "nnInterpolate");
+	job->max_r = DEFAULT_MAX_RADIUS;
+	job->k = DEFAULT_IDW_K;
+	job->power = DEFAULT_IDW_POWER;
+	job->chunk_rows = AF_CHUNK_ROWS;
+	job->deflate_level = 4;
+	job->encoding = AF_ENC_REAL;
+	job->scale_factor = AF_INT16_SCALE;
+	job->add_offset = AF_INT16_OFFSET;
+}
+
+//Reads the jobs of one parameter file. Settings before the first [job] line apply to every job of the file;
+//a file without [job] lines is a single job. Returns -1 on a file error or when there are too many jobs
+static int parse_params(char* path, af_job* jobs, int* num_jobs, af_run_options* options, int rank){
+	FILE* file = fopen(path, "r");
+	if(file == NULL){
+		printf("Input parameters file does not exist: %s\n", path);
+		return -1;
+	}
+	af_job defaults;
+	default_job(&defaults);
+	af_job* job = &defaults;
+	int first_job = *num_jobs;
+	//Resolution belongs to the instrument named last
+	char* section = "";
+	char line[256];
+	while(fgets(line, sizeof(line), file)){
+		trim_value(line);
+		if(strcmp(line, "[job]") == 0){
+			if(*num_jobs == MAX_JOBS){
+				printf("More than %d jobs\n", MAX_JOBS);
+				fclose(file);
+				return -1;
+			}
+			job = &jobs[*num_jobs];
+			*job = defaults;
+			*num_jobs += 1;
+			continue;
+		}
+		char* arg = strchr(line,'=');
+		if(line[0] == '#' || arg == NULL){
+			continue;
+		}
+		*arg = '\0';
+		char* key = line;
+		char* value = arg + 1;
+		if(rank == 0){
+			printf("Found value: %s=%s\n", key, value);
+		}
+		if(strcmp(key, "file_path") == 0){
+			snprintf(job->file_path, AF_PATH_LEN, "%s", value);
+		}
+		else if(strcmp(key, "output_file_path") == 0){
+			snprintf(job->output_file, AF_PATH_LEN, "%s", value);
+		}
+		else if(strcmp(key, "project_instrument") == 0){
+			snprintf(job->project_instrument, 50, "%s", value);
+			section = "project";
+		}
+		else if(strcmp(key, "base_instrument") == 0){
+			snprintf(job->base_instrument, 50, "%s", value);
+			section = "base";
+		}
+		else if(strcmp(key, "resolution") == 0 && strcmp(section, "project") == 0){
+			snprintf(job->misr_args[0], 50, "%s", value);
+		}
+		else if(strcmp(key, "resolution") == 0 && strcmp(section, "base") == 0){
+			snprintf(job->modis_res, 50, "_%s", value);
+		}
+		else if(strcmp(key, "camera_angle") == 0){
+			snprintf(job->misr_args[1], 50, "%s", value);
+		}
+		else if(strcmp(key, "radiance") == 0){
+			snprintf(job->misr_args[2], 50, "%s", value);
+		}
+		else if(strcmp(key, "method") == 0){
+			snprintf(job->method, 50, "%s", value);
+		}
+		else if(strcmp(key, "max_radius") == 0){
+			job->max_r = atof(value);
+		}
+		else if(strcmp(key, "neighbors") == 0){
+			job->k = atoi(value);
+		}
+		else if(strcmp(key, "power") == 0){
+			job->power = atof(value);
+		}
+		else if(strcmp(key, "chunk_rows") == 0){
+			job->chunk_rows = atoi(value) > 0 ? atoi(value) : AF_CHUNK_ROWS;
+		}
+		else if(strcmp(key, "deflate_level") == 0){
+			job->deflate_level = atoi(value);
+		}
+		else if(strcmp(key, "output_encoding") == 0){
+			if(strcmp(value, "float32") == 0){
+				job->encoding = AF_ENC_FLOAT32;
+			}
+			else if(strcmp(value, "int16") == 0){
+				job->encoding = AF_ENC_INT16;
+			}
+			else{
+				job->encoding = AF_ENC_REAL;
+			}
+		}
+		else if(strcmp(key, "scale_factor") == 0){
+			job->scale_factor = atof(value);
+		}
+		else if(strcmp(key, "add_offset") == 0){
+			job->add_offset = atof(value);
+		}
+		else if(strcmp(key, "output_mode") == 0){
+			options->shared_output = strcmp(value, "shared") == 0;
+		}
+		else if(strcmp(key, "nn_cache") == 0){
+			snprintf(options->nn_cache, AF_PATH_LEN, "%s", value);
+		}
+		else if(strncmp(key, "mpi_info_", 9) == 0 && options->num_hints < MAX_MPI_HINTS){
+			size_t key_len = strlen(key + 9);
+			size_t value_len = strlen(value);
+			if(key_len >= 50 || value_len >= 50){
+				printf("MPI-IO hint too long, ignored: %s\n", key);
+			}
+			else{
+				memcpy(options->hint_keys[options->num_hints], key + 9, key_len + 1);
+				memcpy(options->hint_values[options->num_hints], value, value_len + 1);
+				options->num_hints += 1;
+			}
+		}
+		else if(strcmp(key, "band") == 0){
+			//One band per line or a comma separated list
+			char* band = strtok(value, ",");
+			while(band != NULL && job->num_bands < MAX_MODIS_BANDS){
+				snprintf(job->bands[job->num_bands], 50, "%s", band);
+				job->num_bands += 1;
+				band = strtok(NULL, ",");
+			}
+		}
+		else{
+			printf("Unknown parameter: %s\n", key);
+		}
+	}
+	fclose(file);
+	if(*num_jobs == first_job){
+		if(*num_jobs == MAX_JOBS){
+			printf("More than %d jobs\n", MAX_JOBS);
+			return -1;
+		}
+		jobs[*num_jobs] = defaults;
+		*num_jobs += 1;
+	}
+	return 0;
+}
+
+static int check_job(af_job* job){
+	if(strcmp(job->project_instrument, "MISR") != 0 || strcmp(job->base_instrument, "MODIS") != 0){
+		printf("%s: only MISR onto MODIS is supported\n", job->output_file);
+		return -1;
+	}
+	if(strcmp(job->method, "nnInterpolate") != 0 && strcmp(job->method, "idwInterpolate") != 0){
+		printf("%s: method %s is not supported, use nnInterpolate or idwInterpolate\n", job->output_file, job->method);
+		return -1;
+	}
+	if(strcmp(job->method, "idwInterpolate") == 0 && job->k < 1){
+		printf("%s: neighbors must be positive\n", job->output_file);
+		return -1;
+	}
+	if(job->encoding == AF_ENC_INT16 && job->scale_factor <= 0){
+		printf("%s: scale_factor must be positive\n", job->output_file);
+		return -1;
+	}
+	if(job->num_bands == 0){
+		printf("%s: no MODIS band given\n", job->output_file);
+		return -1;
+	}
+	if(strlen(job->file_path) == 0 || strlen(job->output_file) == 0){
+		printf("Missing file_path or output_file_path\n");
+		return -1;
+	}
+	return 0;
+}
+
+//Fills the plan tables so every piece of shared work appears once, and points each job at its entries
+static int build_plan(af_job* jobs, int num_jobs, af_plan* plan){
+	memset(plan, 0, sizeof(af_plan));
+	int j, i, b;
+	for(j = 0; j < num_jobs; j++){
+		af_job* job = &jobs[j];
+		for(i = 0; i < plan->num_groups; i++){
+			af_plan_group* g = &plan->groups[i];
+			if(strcmp(g->file_path, job->file_path) == 0 && strcmp(g->misr_res, job->misr_args[0]) == 0 && strcmp(g->modis_res, job->modis_res) == 0){
+				break;
+			}
+		}
+		if(i == plan->num_groups){
+			plan->groups[i].file_path = job->file_path;
+			plan->groups[i].misr_res = job->misr_args[0];
+			plan->groups[i].modis_res = job->modis_res;
+			plan->groups[i].max_r = 0;
+			plan->num_groups += 1;
+		}
+		job->group = i;
+		plan->groups[i].max_r = job->max_r > plan->groups[i].max_r ? job->max_r : plan->groups[i].max_r;
+
+		af_mapping_kind kind = strcmp(job->method, "idwInterpolate") == 0 ? AF_MAP_KNN : AF_MAP_NN;
+		int k = kind == AF_MAP_KNN ? job->k : 1;
+		for(i = 0; i < plan->num_mappings; i++){
+			af_plan_mapping* m = &plan->mappings[i];
+			if(m->group == job->group && m->kind == kind && m->max_r == job->max_r && m->k == k){
+				break;
+			}
+		}
+		if(i == plan->num_mappings){
+			plan->mappings[i].group = job->group;
+			plan->mappings[i].kind = kind;
+			plan->mappings[i].max_r = job->max_r;
+			plan->mappings[i].k = k;
+			plan->num_mappings += 1;
+		}
+		job->mapping = i;
+
+		for(i = 0; i < plan->num_misr_rads; i++){
+			af_plan_misr_rad* r = &plan->misr_rads[i];
+			if(r->group == job->group && strcmp(r->camera, job->misr_args[1]) == 0 && strcmp(r->radiance, job->misr_args[2]) == 0){
+				break;
+			}
+		}
+		if(i == plan->num_misr_rads){
+			plan->misr_rads[i].group = job->group;
+			plan->misr_rads[i].camera = job->misr_args[1];
+			plan->misr_rads[i].radiance = job->misr_args[2];
+			plan->num_misr_rads += 1;
+		}
+		job->misr_rad = i;
+
+		for(b = 0; b < job->num_bands; b++){
+			for(i = 0; i < plan->num_modis_bands; i++){
+				af_plan_modis_band* mb = &plan->modis_bands[i];
+				if(mb->group == job->group && strcmp(mb->band, job->bands[b]) == 0){
+					break;
+				}
+			}
+			if(i == plan->num_modis_bands){
+				af_plan_modis_band* mb = &plan->modis_bands[i];
+				mb->group = job->group;
+				mb->band = job->bands[b];
+				mb->dname = get_modis_filename(job->modis_res, mb->band, &mb->band_index);
+				if(mb->dname == NULL){
+					printf("Band %s is not supported for %s resolution\n", mb->band, job->modis_res);
+					return -1;
+				}
+				plan->num_modis_bands += 1;
+			}
+			job->modis_bands[b] = i;
+		}
+	}
+	return 0;
+}
+
+//Output file of a job for this rank, and its datasets: latitude, longitude, MODIS radiance and MISR radiance on MODIS
+static hid_t create_job_output(af_job* job, af_run_options* options, int rank, int size, hsize_t total_rows, hsize_t cols, hid_t* out_sets, af_dataset_schema* out_schemas, char* output_path){
+	hid_t output;
+	hsize_t out_rows = total_rows;
+#ifndef AF_PARALLEL_IO
+	(void)options;
+#endif
+#ifdef AF_PARALLEL_IO
+	if(options->shared_output){
+		MPI_Info info;
+		MPI_Info_create(&info);
+		//Collective buffering on by default; data sieving only helps independent writes
+		MPI_Info_set(info, "romio_cb_write", "enable");
+		MPI_Info_set(info, "romio_ds_write", "disable");
+		int h;
+		for(h = 0; h < options->num_hints; h++){
+			MPI_Info_set(info, options->hint_keys[h], options->hint_values[h]);
+		}
+		snprintf(output_path, AF_PATH_LEN, "%s", job->output_file);
+		output = af_create_output_mpio(output_path, MPI_COMM_WORLD, info);
+		MPI_Info_free(&info);
+	}
+	else
+#endif
+	{
+		if(rank_output_path(job->output_file, rank, size, output_path) < 0){
+			return -1;
+		}
+		output = H5Fcreate(output_path, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+		//Files of their own grow by each piece
+		out_rows = 0;
+	}
+	if(output < 0){
+		return output;
+	}
+	char* out_names[4] = {"/Geolocation/Latitude", "/Geolocation/Longitude", "/Data_Fields/modis_rad", "/Data_Fields/misr_out"};
+	int d;
+	for(d = 0; d < 4; d++){
+		af_dataset_schema schema = af_default_schema(out_names[d], d == 2 ? job->num_bands : 0, cols);
+		schema.chunk_rows = job->chunk_rows;
+		schema.deflate_level = job->deflate_level;
+		schema.shuffle = job->deflate_level > 0;
+		//int16 steps would be far too coarse for geolocation, which is kept at float32 instead
+		schema.encoding = d < 2 && job->encoding == AF_ENC_INT16 ? AF_ENC_FLOAT32 : job->encoding;
+		schema.scale_factor = job->scale_factor;
+		schema.add_offset = job->add_offset;
+		out_schemas[d] = schema;
+		out_sets[d] = af_create_dataset(output, &out_schemas[d], out_rows);
+	}
+	return output;
+}
+
+//Runs the jobs of one plan group over this rank's scan lines. The rows are processed one granule piece at a
+//time and each piece is written as soon as it is done, so only one granule's worth of data is held at once
+static int run_group(af_plan* plan, int group, af_job* jobs, int num_jobs, af_run_options* options, int rank, int size){
+	af_plan_group* grp = &plan->groups[group];
+	int status = 1;
+	hid_t input = af_open(grp->file_path);
+	if(input < 0){
+		printf("File not found: %s\n", grp->file_path);
+		status = -1;
+	}
+
+	//Decomposition - the orbit's MODIS swath is split into contiguous scan line ranges, one per rank
+	int num_granules = 0;
+	char** granules = NULL;
+	if(status > 0){
+		granules = af_catalog_granules(input, "MODIS", &num_granules);
+		if(granules == NULL){
+			printf("Group not found\n");
+			status = -1;
+		}
+	}
+	char* first_dname = NULL;
+	int i, j, d;
+	for(i = 0; i < plan->num_modis_bands; i++){
+		if(plan->modis_bands[i].group == group){
+			first_dname = plan->modis_bands[i].dname;
+			break;
+		}
+	}
+	hsize_t granule_rows[num_granules > 0 ? num_granules : 1];
+	hsize_t total_rows = 0;
+	hsize_t cols = 0;
+	if(status > 0){
+		total_rows = modis_swath_rows(input, grp->modis_res, first_dname, granules, num_granules, granule_rows);
+		cols = modis_swath_cols(input, grp->modis_res, granules, num_granules, granule_rows);
+		if(total_rows == 0 || cols == 0){
+			printf("No MODIS scan lines in %s\n", grp->file_path);
+			status = -1;
+		}
+	}
+#ifdef AF_PARALLEL_IO
+	//The shared files are created collectively with the swath's shape: either every rank goes on with the
+	//same shape or they all skip the group
+	if(options->shared_output){
+		int all_status;
+		MPI_Allreduce(&status, &all_status, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+		status = all_status;
+		unsigned long long shape[2] = {total_rows, cols};
+		MPI_Bcast(shape, 2, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+		total_rows = shape[0];
+		cols = shape[1];
+	}
+#endif
+	if(status < 0){
+		if(input >= 0){
+			af_close(input);
+		}
+		return status;
+	}
+	hsize_t first_row, num_rows;
+	split_range(total_rows, rank, size, &first_row, &num_rows);
+	printf("rank %d: %s MODIS scan lines [%llu, %llu) of %llu\n", rank, grp->file_path, (unsigned long long)first_row, (unsigned long long)(first_row + num_rows), (unsigned long long)total_rows);
+
+	int num_pieces = 0;
+	hsize_t piece_first[num_granules > 0 ? num_granules : 1];
+	hsize_t piece_rows[num_granules > 0 ? num_granules : 1];
+	hsize_t granule_first = 0;
+	int g;
+	for(g = 0; g < num_granules; g++){
+		hsize_t lo = granule_first > first_row ? granule_first : first_row;
+		hsize_t hi = granule_first + granule_rows[g] < first_row + num_rows ? granule_first + granule_rows[g] : first_row + num_rows;
+		if(hi > lo){
+			piece_first[num_pieces] = lo;
+			piece_rows[num_pieces] = hi - lo;
+			num_pieces += 1;
+		}
+		granule_first += granule_rows[g];
+	}
+	int num_rounds = num_pieces;
+#ifdef AF_PARALLEL_IO
+	//Writes are collective, so every rank takes part in as many rounds as the rank with the most pieces
+	if(options->shared_output){
+		MPI_Allreduce(&num_pieces, &num_rounds, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+	}
+#endif
+
+	//Outputs of the group's jobs; without rows a rank has nothing to write to its own file
+	hid_t outputs[num_jobs];
+	hid_t out_sets[num_jobs][4];
+	af_dataset_schema out_schemas[num_jobs][4];
+	char output_paths[num_jobs][AF_PATH_LEN];
+	for(j = 0; j < num_jobs; j++){
+		outputs[j] = -1;
+		if(jobs[j].group != group || (num_rows == 0 && !options->shared_output)){
+			continue;
+		}
+		outputs[j] = create_job_output(&jobs[j], options, rank, size, total_rows, cols, out_sets[j], out_schemas[j], output_paths[j]);
+		if(outputs[j] < 0){
+			status = -1;
+			continue;
+		}
+		for(d = 0; d < 4; d++){
+			status = out_sets[j][d] < 0 ? -1 : status;
+		}
+	}
+	//One packing buffer for the encoded outputs, sized for the largest piece and reused by every write
+	hsize_t max_piece_rows = 0;
+	for(i = 0; i < num_pieces; i++){
+		max_piece_rows = piece_rows[i] > max_piece_rows ? piece_rows[i] : max_piece_rows;
+	}
+	size_t pack_bytes = 0;
+	for(j = 0; j < num_jobs; j++){
+		for(d = 0; d < 4 && outputs[j] >= 0; d++){
+			size_t bytes = af_pack_size(&out_schemas[j][d]) * max_piece_rows * cols * (out_schemas[j][d].bands > 0 ? out_schemas[j][d].bands : 1);
+			pack_bytes = bytes > pack_bytes ? bytes : pack_bytes;
+		}
+	}
+	void* packed = NULL;
+	if(pack_bytes > 0 && NULL == (packed = malloc(pack_bytes))){
+		printf("Out of memory for the output packing buffer\n");
+		status = -1;
+	}
+#ifdef AF_PARALLEL_IO
+	//Outputs are created collectively; if any rank failed, none of them starts the collective write rounds
+	if(options->shared_output){
+		int all_status;
+		MPI_Allreduce(&status, &all_status, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+		status = all_status;
+	}
+#endif
+	if(status < 0){
+		num_rounds = 0;
+	}
+
+	//The group's MODIS bands, read together for each piece
+	int num_bands = 0;
+	int band_slot[plan->num_modis_bands > 0 ? plan->num_modis_bands : 1];
+	char* dnames[plan->num_modis_bands > 0 ? plan->num_modis_bands : 1];
+	int band_indices[plan->num_modis_bands > 0 ? plan->num_modis_bands : 1];
+	for(i = 0; i < plan->num_modis_bands; i++){
+		band_slot[i] = -1;
+		if(plan->modis_bands[i].group == group){
+			band_slot[i] = num_bands;
+			dnames[num_bands] = plan->modis_bands[i].dname;
+			band_indices[num_bands] = plan->modis_bands[i].band_index;
+			num_bands += 1;
+		}
+	}
+
+	//MISR blocks of the previous piece, with their geolocation and radiances, kept while the next piece needs the same ones
+	int first_block = 0;
+	int num_blocks = -1;
+	int n_misr = 0;
+	af_real* misr_lat = NULL;
+	af_real* misr_lon = NULL;
+	af_real* misr_rads[plan->num_misr_rads];
+	for(i = 0; i < plan->num_misr_rads; i++){
+		misr_rads[i] = NULL;
+	}
+	int* map_ids[plan->num_mappings];
+	double* map_dis[plan->num_mappings];
+	//Ranks keep their mappings apart, so re-running the orbit with the same rank count finds each piece's mapping
+	char cache_path[AF_PATH_LEN] = "";
+	if(options->nn_cache[0] != '\0' && rank_output_path(options->nn_cache, rank, size, cache_path) < 0){
+		cache_path[0] = '\0';
+	}
+	nnWorkspace* ws = nnWorkspaceCreate();
+	int p;
+	for(p = 0; p < num_rounds; p++){
+		hsize_t p_first = p < num_pieces ? piece_first[p] : 0;
+		hsize_t p_rows = p < num_pieces ? piece_rows[p] : 0;
+		int n_modis = 0;
+		af_real* modis_lat = NULL;
+		af_real* modis_lon = NULL;
+		af_real* modis_rad = NULL;
+		for(i = 0; i < plan->num_mappings; i++){
+			map_ids[i] = NULL;
+			map_dis[i] = NULL;
+		}
+		if(p_rows > 0 && status > 0){
+			modis_lat = modis_read_geo_rows(input, grp->modis_res, first_dname, "Latitude", granules, num_granules, p_first, p_rows, &n_modis);
+			modis_lon = modis_read_geo_rows(input, grp->modis_res, first_dname, "Longitude", granules, num_granules, p_first, p_rows, &n_modis);
+			if(modis_lat == NULL || modis_lon == NULL){
+				printf("MODIS geolocation read error\n");
+				status = -1;
+				n_modis = 0;
+			}
+		}
+		//Only the MISR blocks within reach of this piece's scan lines are read, for the largest radius of the group
+		int p_first_block = 0;
+		int p_num_blocks = 0;
+		if(n_modis > 0 && status > 0 && misr_block_range(input, grp->misr_res, modis_lat, modis_lon, n_modis, grp->max_r, &p_first_block, &p_num_blocks) < 0){
+			status = -1;
+		}
+		if(n_modis > 0 && status > 0 && (p_first_block != first_block || p_num_blocks != num_blocks)){
+			free(misr_lat);
+			free(misr_lon);
+			misr_lat = misr_lon = NULL;
+			for(i = 0; i < plan->num_misr_rads; i++){
+				free(misr_rads[i]);
+				misr_rads[i] = NULL;
+			}
+			first_block = p_first_block;
+			num_blocks = p_num_blocks;
+			printf("rank %d: MISR blocks [%d, %d) for scan lines [%llu, %llu)\n", rank, first_block, first_block + num_blocks, (unsigned long long)p_first, (unsigned long long)(p_first + p_rows));
+			if(num_blocks > 0){
+				char* location = strcmp(grp->misr_res, "H") == 0 ? "/MISR/HRGeolocation" : "/MISR/Geolocation";
+				char lat_name[AF_PATH_LEN];
+				char lon_name[AF_PATH_LEN];
+				snprintf(lat_name, AF_PATH_LEN, "%s/GeoLatitude", location);
+				snprintf(lon_name, AF_PATH_LEN, "%s/GeoLongitude", location);
+				misr_lat = af_read_slab(input, lat_name, 0, first_block, num_blocks, &n_misr);
+				misr_lon = af_read_slab(input, lon_name, 0, first_block, num_blocks, &n_misr);
+				if(misr_lat == NULL || misr_lon == NULL){
+					printf("MISR read error\n");
+					status = -1;
+				}
+				for(i = 0; i < plan->num_misr_rads && status > 0; i++){
+					if(plan->misr_rads[i].group != group){
+						continue;
+					}
+					int n_misr_rad;
+					misr_rads[i] = get_misr_rad_blocks(input, plan->misr_rads[i].camera, grp->misr_res, plan->misr_rads[i].radiance, first_block, num_blocks, &n_misr_rad);
+					if(misr_rads[i] == NULL || n_misr_rad != n_misr){
+						printf("MISR read error\n");
+						status = -1;
+					}
+				}
+			}
+		}
+		//Each mapping of the group once per piece, shared by all jobs using it
+		if(n_modis > 0 && status > 0 && num_blocks > 0){
+			sphereTree* tree = NULL;
+			for(i = 0; i < plan->num_mappings; i++){
+				af_plan_mapping* m = &plan->mappings[i];
+				if(m->group != group){
+					continue;
+				}
+				if(m->kind == AF_MAP_NN){
+					//A mapping an earlier run computed over the same geolocation and radius is read back instead
+					unsigned long long key = 0;
+					if(cache_path[0] != '\0'){
+						key = nnMappingKey(misr_lat, misr_lon, n_misr, modis_lat, modis_lon, n_modis, m->max_r);
+						map_ids[i] = af_read_nn_mapping(cache_path, key, n_modis);
+					}
+					if(map_ids[i] == NULL){
+						map_ids[i] = (int *)malloc(sizeof(int) * n_modis);
+						nearestNeighborConst(ws, misr_lat, misr_lon, n_misr, modis_lat, modis_lon, map_ids[i], n_modis, m->max_r);
+						if(cache_path[0] != '\0' && af_write_nn_mapping(cache_path, key, map_ids[i], n_modis) < 0){
+							printf("rank %d: mapping not cached in %s\n", rank, cache_path);
+						}
+					}
+				}
+				else{
+					if(tree == NULL){
+						tree = sphereTreeCreate(misr_lat, misr_lon, n_misr);
+					}
+					map_ids[i] = (int *)malloc(sizeof(int) * n_modis * m->k);
+					map_dis[i] = (double *)malloc(sizeof(double) * n_modis * m->k);
+					kNearestNeighborOnTree(tree, modis_lat, modis_lon, n_modis, m->k, m->max_r, map_ids[i], map_dis[i]);
+				}
+			}
+			if(tree != NULL){
+				sphereTreeFree(tree);
+			}
+		}
+		if(n_modis > 0 && status > 0){
+			int n_modis_rad;
+			modis_rad = modis_read_band_rows(input, grp->modis_res, granules, num_granules, dnames, band_indices, num_bands, p_first, p_rows, &n_modis_rad);
+			if(modis_rad == NULL){
+				status = -1;
+			}
+		}
+
+		for(j = 0; j < num_jobs; j++){
+			af_job* job = &jobs[j];
+			if(job->group != group || outputs[j] < 0){
+				continue;
+			}
+			af_real* misr_out = NULL;
+			af_real* job_rad = NULL;
+			if(n_modis > 0 && status > 0){
+				misr_out = (af_real *)malloc(sizeof(af_real) * n_modis);
+				job_rad = (af_real *)malloc(sizeof(af_real) * n_modis * job->num_bands);
+				if(num_blocks <= 0){
+					for(i = 0; i < n_modis; i++){
+						misr_out[i] = -999;
+					}
+				}
+				else if(plan->mappings[job->mapping].kind == AF_MAP_NN){
+					nnInterpolate(misr_rads[job->misr_rad], misr_out, map_ids[job->mapping], n_modis);
+				}
+				else{
+					idwInterpolate(misr_rads[job->misr_rad], misr_out, map_ids[job->mapping], map_dis[job->mapping], n_modis, job->k, job->power);
+				}
+				int b;
+				for(b = 0; b < job->num_bands; b++){
+					memcpy(&job_rad[(size_t)b * n_modis], &modis_rad[(size_t)band_slot[job->modis_bands[b]] * n_modis], sizeof(af_real) * n_modis);
+				}
+			}
+			af_real* out_data[4] = {modis_lat, modis_lon, job_rad, misr_out};
+			for(d = 0; d < 4; d++){
+#ifdef AF_PARALLEL_IO
+				if(options->shared_output){
+					//A rank that failed or ran out of pieces still joins the collective write, with no rows
+					hsize_t w_rows = status > 0 ? p_rows : 0;
+					if(af_write_dataset_rows(out_sets[j][d], &out_schemas[j][d], out_data[d], p_first, w_rows, packed) < 0){
+						status = -1;
+					}
+					continue;
+				}
+#endif
+				if(status > 0 && af_append_rows(out_sets[j][d], &out_schemas[j][d], out_data[d], p_rows, packed) < 0){
+					status = -1;
+				}
+			}
+			free(misr_out);
+			free(job_rad);
+		}
+		for(i = 0; i < plan->num_mappings; i++){
+			free(map_ids[i]);
+			free(map_dis[i]);
+		}
+		free(modis_lat);
+		free(modis_lon);
+		free(modis_rad);
+	}
+	nnWorkspaceFree(ws);
+	free(misr_lat);
+	free(misr_lon);
+	for(i = 0; i < plan->num_misr_rads; i++){
+		free(misr_rads[i]);
+	}
+	free(packed);
+	if(input >= 0){
+		af_close(input);
+	}
+
+	for(j = 0; j < num_jobs; j++){
+		if(outputs[j] < 0){
+			continue;
+		}
+		for(d = 0; d < 4; d++){
+			if(out_sets[j][d] >= 0){
+				H5Dclose(out_sets[j][d]);
+			}
+		}
+		H5Fclose(outputs[j]);
+		printf("rank %d: wrote %s\n", rank, output_paths[j]);
+	}
+	return status;
+}
+
+int main(int argc, char ** argv) {
+	int rank = 0;
+	int size = 1;
+#ifdef AF_USE_MPI
+	MPI_Init(&argc, &argv);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &size);
+#endif
+	if(argc < 2){
+		if(rank == 0){
+			printf("Usage: ./af_run input_parameters.txt [more_parameters.txt ...]\n");
+		}
+		return af_run_exit(-1);
+	}
+
+	//Jobs of all parameter files given
+	af_job* jobs = (af_job *)malloc(sizeof(af_job) * MAX_JOBS);
+	int num_jobs = 0;
+	af_run_options options;
+	memset(&options, 0, sizeof(af_run_options));
+	//Ranks write one shared file when the HDF5 library is parallel, their own files otherwise
+#ifdef AF_PARALLEL_IO
+	options.shared_output = 1;
+#endif
+	int a;
+	for(a = 1; a < argc; a++){
+		if(parse_params(argv[a], jobs, &num_jobs, &options, rank) < 0){
+			free(jobs);
+			return af_run_exit(-1);
+		}
+	}
+	int j;
+	for(j = 0; j < num_jobs; j++){
+		if(check_job(&jobs[j]) < 0){
+			free(jobs);
+			return af_run_exit(-1);
+		}
+	}
+#ifndef AF_PARALLEL_IO
+	if(options.shared_output && size > 1){
+		if(rank == 0){
+			printf("Shared output needs a parallel HDF5 build, writing one file per rank\n");
+		}
+		options.shared_output = 0;
+	}
+#endif
+	if(options.num_hints > 0 && !options.shared_output && rank == 0){
+		printf("mpi_info_ hints only apply to shared output\n");
+	}
+
+	af_plan* plan = (af_plan *)malloc(sizeof(af_plan));
+	if(build_plan(jobs, num_jobs, plan) < 0){
+		free(plan);
+		free(jobs);
+		return af_run_exit(-1);
+	}
+	if(rank == 0){
+		printf("Plan: %d outputs, %d input passes, %d neighbor mappings, %d MISR radiances, %d MODIS bands\n", num_jobs, plan->num_groups, plan->num_mappings, plan->num_misr_rads, plan->num_modis_bands);
+	}
+
+	struct timeval start_time, end_time;
+	gettimeofday(&start_time, NULL);
+	int status = 1;
+	int g;
+	for(g = 0; g < plan->num_groups; g++){
+		if(run_group(plan, g, jobs, num_jobs, &options, rank, size) < 0){
+			status = -1;
+		}
+	}
+	free(plan);
+	free(jobs);
+
+	gettimeofday(&end_time, NULL);
+	printf("rank %d: done in %f seconds\n", rank, (end_time.tv_sec - start_time.tv_sec) + (end_time.tv_usec - start_time.tv_usec) / 1000000.0);
+	return af_run_exit(status > 0 ? 0 : -1);
+}
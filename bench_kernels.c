@@ -0,0 +1,306 @@
+/**
+ * bench_kernels.c
+ * Microbenchmarks of the reprojection and aggregation kernels on synthetic swaths.
+ * Build and run with "make bench"; reproject.c is compiled with -DAF_BENCH_STATS so the
+ * nearest neighbor search reports how many source cells it compared.
+ *
+ * Usage: ./bench_kernels [ntar=N] [density=D] [lat=L] [maxr=R] [spacing=S] [blocks=B] [reps=K]
+ *	ntar:		the number of target cells (default 262144)
+ *	density:	source cells per target cell, e.g. 16 for 275m MISR onto 1.1km MODIS (default 4)
+ *	lat:		the latitude of the swath center in degrees (default 0)
+ *	maxr:		the search radius in meters (default 1000)
+ *	spacing:	the target spacing in meters (default 1000)
+ *	blocks:		the number of 512 x 2048 planes averaged by blockAverage (default 4)
+ *	reps:		the number of timed runs of each kernel; the fastest is reported (default 3)
+ * Without ntar, density, lat or maxr a fixed set of swaths is run: latitudes 0, 60 and 85, densities 4
+ * and 16, and radii 1000 and 5000.
+ *
+ * Columns: ns/item is the time per target (per source for pointIndexOnLat and summaryInterpolate, per
+ * output cell for blockAverage), cand/query the source cells compared per target, MB/s the bytes
+ * the kernel has to read and write divided by its time.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <sys/time.h>
+#include "reproject.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#ifndef M_PI
+#    define M_PI 3.14159265358979323846
+#endif
+
+typedef struct {
+	int nTar;
+	double density;
+	double lat;
+	double maxR;
+	double spacing;
+} benchCase;
+
+static double now() {
+
+	struct timeval t;
+	gettimeofday(&t, NULL);
+	return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+static void * benchAlloc(size_t n, size_t size) {
+
+	void * p;
+	if(NULL == (p = malloc(n * size))) {
+		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
+		exit(1);
+	}
+	return p;
+}
+
+//Regular grid of about n cells spaced spacing meters around (lat, 0), rotated like a polar orbit track
+//crossing the latitude. A small deterministic jitter keeps distances from tying everywhere
+static int makeSwath(int n, double spacing, double lat, af_real ** pLat, af_real ** pLon) {
+
+	const double earthRadius = 6367444;
+	int nCols = (int)sqrt((double)n);
+	int nRows = (n + nCols - 1) / nCols;
+	n = nRows * nCols;
+	af_real * gLat = (af_real *)benchAlloc(n, sizeof(af_real));
+	af_real * gLon = (af_real *)benchAlloc(n, sizeof(af_real));
+	double step = spacing / earthRadius * 180 / M_PI;
+	double angle = 8 * M_PI / 180;
+	unsigned int seed = 12345;
+	int r, c;
+	for(r = 0; r < nRows; r++) {
+		for(c = 0; c < nCols; c++) {
+			double x = (c - nCols / 2.0) * step;
+			double y = (r - nRows / 2.0) * step;
+			seed = seed * 1103515245 + 12345;
+			double jitter = ((seed >> 16) & 0x7fff) / 32768.0 - 0.5;
+			double pLatDeg = lat + y * cos(angle) - x * sin(angle) + 0.05 * step * jitter;
+			if(pLatDeg > 90) {
+				pLatDeg = 90;
+			}
+			double cosLat = cos(pLatDeg * M_PI / 180);
+			double pLonDeg = (x * cos(angle) + y * sin(angle)) / (cosLat > 0.01 ? cosLat : 0.01);
+			gLat[r * nCols + c] = pLatDeg;
+			gLon[r * nCols + c] = pLonDeg;
+		}
+	}
+	*pLat = gLat;
+	*pLon = gLon;
+	return n;
+}
+
+//Radiance like values with about 1% fill
+static af_real * makeValues(int n) {
+
+	af_real * val = (af_real *)benchAlloc(n, sizeof(af_real));
+	unsigned int seed = 777;
+	int i;
+	for(i = 0; i < n; i++) {
+		seed = seed * 1103515245 + 12345;
+		int v = (seed >> 16) & 0x7fff;
+		val[i] = v % 100 == 0 ? -999 : v / 100.0;
+	}
+	return val;
+}
+
+static void report(const char * kernel, long long items, double seconds, double candidates, double bytes) {
+
+	char cand[32];
+	if(candidates >= 0) {
+		snprintf(cand, sizeof(cand), "%.1f", candidates);
+	}
+	else {
+		snprintf(cand, sizeof(cand), "-");
+	}
+	printf("%-20s %12lld %12.2f %12s %12.1f\n", kernel, items, seconds * 1e9 / (items > 0 ? items : 1), cand, bytes / seconds / 1e6);
+}
+
+static void runCase(benchCase * bc, int reps) {
+
+	af_real * tarLat, * tarLon;
+	af_real * souLat, * souLon;
+	int nTar = makeSwath(bc->nTar, bc->spacing, bc->lat, &tarLat, &tarLon);
+	int nSou = makeSwath((int)(nTar * bc->density), bc->spacing / sqrt(bc->density), bc->lat, &souLat, &souLon);
+	af_real * souVal = makeValues(nSou);
+	af_real * tarVal = (af_real *)benchAlloc(nTar, sizeof(af_real));
+	int * tarNNSouID = (int *)benchAlloc(nTar, sizeof(int));
+	int * souNNTarID = (int *)benchAlloc(nSou, sizeof(int));
+	int * nSouPixels = (int *)benchAlloc(nTar, sizeof(int));
+
+	printf("\nlat=%.1f density=%.1f maxR=%.0f spacing=%.0f nSou=%d nTar=%d\n", bc->lat, bc->density, bc->maxR, bc->spacing, nSou, nTar);
+	printf("%-20s %12s %12s %12s %12s\n", "kernel", "items", "ns/item", "cand/query", "MB/s");
+
+	nnWorkspace * ws = nnWorkspaceCreate();
+	double best, t;
+	int rep;
+
+	//Latitude band sort: reads the latitudes, writes source IDs
+	nnBenchIndexOnLat(ws, souLat, nSou, bc->maxR);
+	best = HUGE_VAL;
+	for(rep = 0; rep < reps; rep++) {
+		t = now();
+		nnBenchIndexOnLat(ws, souLat, nSou, bc->maxR);
+		t = now() - t;
+		best = t < best ? t : best;
+	}
+	report("pointIndexOnLat", nSou, best, -1, (double)nSou * (sizeof(af_real) + sizeof(int)));
+
+	//Nearest neighbor: reads source and target geolocation, writes one ID per target
+	nearestNeighborConst(ws, souLat, souLon, nSou, tarLat, tarLon, tarNNSouID, nTar, bc->maxR);
+	best = HUGE_VAL;
+	long long candidates = 0;
+	for(rep = 0; rep < reps; rep++) {
+		nnCandidateCount = 0;
+		t = now();
+		nearestNeighborConst(ws, souLat, souLon, nSou, tarLat, tarLon, tarNNSouID, nTar, bc->maxR);
+		t = now() - t;
+		best = t < best ? t : best;
+		candidates = nnCandidateCount;
+	}
+	int i, found = 0;
+	for(i = 0; i < nTar; i++) {
+		found += tarNNSouID[i] >= 0;
+	}
+	report("nearestNeighbor", nTar, best, (double)candidates / nTar, (double)(nSou + nTar) * 2 * sizeof(af_real) + (double)nTar * sizeof(int));
+
+	//Gather: reads an ID and a source value, writes a target value
+	best = HUGE_VAL;
+	for(rep = 0; rep < reps; rep++) {
+		t = now();
+		nnInterpolate(souVal, tarVal, tarNNSouID, nTar);
+		t = now() - t;
+		best = t < best ? t : best;
+	}
+	report("nnInterpolate", nTar, best, -1, (double)nTar * (sizeof(int) + 2 * sizeof(af_real)));
+
+	//Aggregation: reads an ID and a value per source, writes a value and a count per target
+	nearestNeighborConst(ws, tarLat, tarLon, nTar, souLat, souLon, souNNTarID, nSou, bc->maxR);
+	best = HUGE_VAL;
+	for(rep = 0; rep < reps; rep++) {
+		t = now();
+		summaryInterpolate(souVal, souNNTarID, nSou, tarVal, nSouPixels, nTar);
+		t = now() - t;
+		best = t < best ? t : best;
+	}
+	report("summaryInterpolate", nSou, best, -1, (double)nSou * (sizeof(int) + sizeof(af_real)) + (double)nTar * (sizeof(int) + sizeof(af_real)));
+	printf("targets with a neighbor: %d of %d\n", found, nTar);
+
+	nnWorkspaceFree(ws);
+	free(tarLat);
+	free(tarLon);
+	free(souLat);
+	free(souLon);
+	free(souVal);
+	free(tarVal);
+	free(tarNNSouID);
+	free(souNNTarID);
+	free(nSouPixels);
+}
+
+//MISR 275m blocks (512 x 2048) averaged to 1.1km: reads every input cell, writes every output cell
+static void runBlockAverage(int nPlanes, int reps) {
+
+	int nRows = 512;
+	int nCols = 2048;
+	int factor = 4;
+	size_t nSou = (size_t)nPlanes * nRows * nCols;
+	size_t nTar = nSou / (factor * factor);
+	af_real * souVal = makeValues(nSou);
+	af_real * tarVal = (af_real *)benchAlloc(nTar, sizeof(af_real));
+
+	printf("\nblocks=%d %d x %d factor=%d\n", nPlanes, nRows, nCols, factor);
+	printf("%-20s %12s %12s %12s %12s\n", "kernel", "items", "ns/item", "cand/query", "MB/s");
+	blockAverage(souVal, tarVal, nPlanes, nRows, nCols, factor);
+	double best = HUGE_VAL;
+	int rep;
+	for(rep = 0; rep < reps; rep++) {
+		double t = now();
+		blockAverage(souVal, tarVal, nPlanes, nRows, nCols, factor);
+		t = now() - t;
+		best = t < best ? t : best;
+	}
+	report("blockAverage", nTar, best, -1, (double)(nSou + nTar) * sizeof(af_real));
+
+	free(souVal);
+	free(tarVal);
+}
+
+int main(int argc, char ** argv) {
+
+	benchCase single = {262144, 4, 0, 1000, 1000};
+	int nPlanes = 4;
+	int reps = 3;
+	int custom = 0;
+	int a;
+	for(a = 1; a < argc; a++) {
+		char * value = strchr(argv[a], '=');
+		if(value == NULL) {
+			printf("Arguments are key=value, see the top of bench_kernels.c\n");
+			return 1;
+		}
+		value ++;
+		if(strncmp(argv[a], "ntar=", 5) == 0) {
+			single.nTar = atoi(value);
+			custom = 1;
+		}
+		else if(strncmp(argv[a], "density=", 8) == 0) {
+			single.density = atof(value);
+			custom = 1;
+		}
+		else if(strncmp(argv[a], "lat=", 4) == 0) {
+			single.lat = atof(value);
+			custom = 1;
+		}
+		else if(strncmp(argv[a], "maxr=", 5) == 0) {
+			single.maxR = atof(value);
+			custom = 1;
+		}
+		else if(strncmp(argv[a], "spacing=", 8) == 0) {
+			single.spacing = atof(value);
+		}
+		else if(strncmp(argv[a], "blocks=", 7) == 0) {
+			nPlanes = atoi(value);
+		}
+		else if(strncmp(argv[a], "reps=", 5) == 0) {
+			reps = atoi(value) > 0 ? atoi(value) : 1;
+		}
+		else {
+			printf("Unknown argument: %s\n", argv[a]);
+			return 1;
+		}
+	}
+	if(single.nTar < 1 || single.density <= 0 || single.maxR <= 0 || single.spacing <= 0) {
+		printf("ntar, density, maxr and spacing must be positive\n");
+		return 1;
+	}
+
+	int nThreads = 1;
+#ifdef _OPENMP
+	nThreads = omp_get_max_threads();
+#endif
+	printf("af_real: %d bytes, threads: %d, best of %d runs\n", (int)sizeof(af_real), nThreads, reps);
+
+	if(custom) {
+		runCase(&single, reps);
+	}
+	else {
+		benchCase cases[] = {
+			{262144, 4, 0, 1000, 1000},
+			{262144, 4, 60, 1000, 1000},
+			{262144, 4, 85, 1000, 1000},
+			{262144, 16, 0, 1000, 1000},
+			{262144, 4, 0, 5000, 1000},
+		};
+		int c;
+		for(c = 0; c < (int)(sizeof(cases) / sizeof(cases[0])); c++) {
+			cases[c].spacing = single.spacing;
+			runCase(&cases[c], reps);
+		}
+	}
+	runBlockAverage(nPlanes, reps);
+	return 0;
+}
@@ -1,1755 +1,2429 @@
-/*
-
-
-    AUTHOR:
-        Yat Long Lo
-
-    EMAIL:
-        yllo2@illinois.edu
-
-
-*/
-
-#include "io.h"
-#include <hdf5.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <strings.h>
-#include <string.h>
-#include <assert.h>
-#define FALSE   0
-
-//Band constants for MODIS
-char* m_250_list[2] = {"1", "2"};
-char* m_500_list[5] = {"3", "4", "5", "6", "7"};
-char* km_1_ref_list[15] = {"8", "9", "10", "11", "12", "13L", "13H", "14L", "14H", "15", "16", "17", "18", "19", "26"};
-char* kme_1_list[16] = {"20", "21", "22", "23", "24", "25", "27", "28", "29", "30", "31", "32", "33", "34", "35", "36"};
-
-
-double* get_misr_rad(hid_t file, char* camera_angle, char* resolution, char* radiance, int* size){
-	//Path to dataset proccessing 
-	int down_sampling = 0;
-	char* instrument = "MISR";
-	char* d_fields = "Data_Fields";
-	const char* arr[] = {instrument, camera_angle, d_fields, radiance};
-	
-	//Dataset name parsing
-	char* rad_dataset_name;
-	concat_by_sep(&rad_dataset_name, arr, "/", strlen(instrument) + strlen(camera_angle) + strlen(d_fields) + strlen(radiance) + 4, 4);
-		//Check for correct specification
-	if(strcmp(camera_angle, "AN") != 0 && strcmp(radiance, "Red_Radiance") != 0 && strcmp(resolution, "H") == 0){
-		printf("Error: Your specification does not support high resolution.\n");
-		return NULL;
-	}
-	else if((strcmp(camera_angle, "AN") == 0 || strcmp(radiance, "Red_Radiance") == 0) && strcmp(resolution, "L") == 0){
-		//Downsampling has to be done
-		down_sampling = 1;
-	}
-	
-	printf("Reading MISR\n");
-	/*Dimensions - 180 blocks, 512 x 2048 ordered in 1D Array*/
-	//Retrieve radiance dataset and dataspace
-	double* data = af_read(file, rad_dataset_name);
-	*size = dim_sum(af_read_size(file, rad_dataset_name), 3);
-	
-	if(data == NULL){
-		return NULL;
-	}
-	printf("Reading successful\n");
-	//Variable containing down sampled data
-	double* down_data;
-	if(down_sampling == 1){
-		printf("Undergoing downsampling\n");
-		hsize_t* dims = af_read_size(file, rad_dataset_name);
-		*size = dims[0] * (dims[1]/4) * (dims[2]/4);
-		down_data = malloc(dims[0] * (dims[1]/4) * (dims[2]/4) * sizeof(double));
-		int i, j, k;
-		for(i = 0; i < dims[0]; i++){
-			for(j = 0; j < dims[1]; j = j + 4){
-				for(k = 0; k < dims[2]; k = k + 4){
-					//Retrieving 4x4 window for averaging
-					//Formula for converting i, j and k to index in data array
-					//int index = i*dims[1]*dims[2] + j*dims[2] + k;
-					int a,b;
-					int max_x = j + 4;
-					int max_z = k + 4; 
-					int* index_array = malloc(16*sizeof(int));
-					int index_iter = 0;
-					for(a = j; a < max_x; a++){
-						for(b = k; b < max_z; b++){
-							index_array[index_iter] = i*dims[1]*dims[2] + a*dims[2] + b;
-							index_iter += 1;
-						}
-					}
-					double* window = malloc(16*sizeof(double));
-					int c;
-					for(c = 0; c < 16; c++){
-						window[c] = data[index_array[c]];
-					}
-					//Window Retrieved, get average and assign to new data grid
-					double average = misr_averaging(window);
-					int new_index = i*dims[1]/4*dims[2]/4 + (j/4)*dims[2]/4 + k/4;
-					down_data[new_index] = average;
-					free(index_array);
-					free(window);
-				}
-			}
-		}
-		free(data);
-		printf("Downsampling done\n");
-	}
-	
-	if(down_sampling == 1){
-		printf("rad_data: %f\n", down_data[0]);
-		return down_data;
-	}
-	else{
-		printf("rad_data: %f\n", data[0]);
-		return data;	
-	}
-	
-}
-
-double* get_misr_lat(hid_t file, char* resolution, int* size){
-	//Path to dataset proccessing 
-	char* instrument = "MISR";
-	char* location;
-	if(strcmp(resolution, "H") == 0){
-		location = "HRGeolocation";
-	}
-	else{
-		location = "Geolocation";
-	}
-	char* lat = "GeoLatitude";
-	const char* arr2[] = {instrument, location, lat};
-	
-	//Dataset names parsing
-	char* lat_dataset_name;
-	concat_by_sep(&lat_dataset_name, arr2, "/", strlen(instrument) + strlen(location) + strlen(lat) + 4, 3);
-	
-	printf("Retrieveing latitude data for MISR\n");
-	//Retrieve latitude dataset and dataspace
-	double* lat_data = af_read(file, lat_dataset_name);
-	*size = dim_sum(af_read_size(file, lat_dataset_name), 3);
-	if(lat_data == NULL){
-		return NULL;
-	}
-	printf("lat_data: %f\n", lat_data[0]);
-	return lat_data;
-}
-
-double* get_misr_long(hid_t file, char* resolution, int* size){
-	//Path to dataset proccessing 
-	char* instrument = "MISR";
-	char* location;
-	if(strcmp(resolution, "H") == 0){
-		location = "HRGeolocation";
-	}
-	else{
-		location = "Geolocation";
-	}
-	char* longitude = "GeoLongitude";
-	const char* arr3[] = {instrument, location, longitude};
-	
-	//Dataset names parsing
-	char* long_dataset_name;
-	concat_by_sep(&long_dataset_name, arr3, "/", strlen(instrument) + strlen(location) + strlen(longitude) + 4, 3);
-	
-	printf("Retrieveing longitude data for MISR\n");
-	//Retrieve longitude dataset and dataspace
-	double* long_data = af_read(file, long_dataset_name);
-	*size = dim_sum(af_read_size(file, long_dataset_name), 3);
-	if(long_data == NULL){
-		return NULL;
-	}
-	printf("long_data: %f\n", long_data[0]);
-	return long_data;
-}
-
-//geo - 0:not geolocation attributes, 1:lat, 2:long
-void* get_misr_attr(hid_t file, char* camera_angle, char* resolution, char* radiance, char* attr_name, int geo, void* attr_pt){
-	//Path variables
-	char* instrument = "MISR";
-	char* d_fields = "Data_Fields";
-	char* location = "Geolocation";
-
-	//Dataset name parsing
-	char* rad_dataset_name;
-	if(geo == 0){
-		const char* arr[4] = {instrument, camera_angle, d_fields, radiance};
-		concat_by_sep(&rad_dataset_name, arr, "/", strlen(instrument) + strlen(camera_angle) + strlen(d_fields) + strlen(radiance) + 4, 4);
-	}
-	else if(geo == 1){
-		char* lat = "GeoLatitude";
-		const char* arr[3] = {instrument, location, lat};
-		concat_by_sep(&rad_dataset_name, arr, "/", strlen(instrument) + strlen(location) + strlen(lat) + 4, 3);
-	}
-	else if(geo == 2){
-		char* longitude = "GeoLongitude";
-		const char* arr[3] = {instrument, location, longitude};
-		concat_by_sep(&rad_dataset_name, arr, "/", strlen(instrument) + strlen(location) + strlen(longitude) + 4, 3);
-	}
-	else{
-		printf("Wrong geo number");
-		return NULL;
-	}
-	
-	//Get attribute
-	hid_t attr = H5Aopen_by_name(file, rad_dataset_name, attr_name, H5P_DEFAULT, H5P_DEFAULT);
-	if(attr < 0){
-		printf("Attribute %s does not exists\n", attr_name);
-	}
-	hid_t attr_type = H5Aget_type(attr);
-	if(strcmp(attr_name, "Units") == 0 || strcmp(attr_name, "units") == 0){
-		attr_pt = malloc(sizeof(char) * 50);
-		H5Aread(attr, attr_type, attr_pt);
-	}
-	else if(strcmp(attr_name, "_FillValue") == 0){
-		attr_pt = malloc(sizeof(float));
-		H5Aread(attr, attr_type, attr_pt);
-	}
-	H5Aclose(attr);
-	
-	return attr_pt;
-}
-
-double* get_modis_rad(hid_t file, char* resolution, char* bands[], int band_size, int* size){
-	printf("Reading MODIS rad\n");
-	
-	//Path variables
-	char* instrument = "MODIS";
-	char* d_fields = "Data_Fields";
-	//Get all granule file names
-	printf("Retrieving granule group names\n");
-	hid_t group = H5Gopen(file, instrument, H5P_DEFAULT);
-	if(group < 0){
-		printf("Group not found\n");
-		return NULL;
-	}
-	hsize_t num_groups;
-	herr_t err = H5Gget_num_objs(group, &num_groups);
-	char* names[(int)num_groups][50];
-	int i;
-	for(i = 0; i < num_groups; i++){
-		char* name = malloc(50*sizeof(char));
-		H5Gget_objname_by_idx(group, (hsize_t)i, name, 50);
-		strcpy(&names[i], name);
-		free(name);
-	}
-	
-	//Get dataset names from bands
-	printf("Retreving dataset names\n");
-	char* dnames[band_size][50];
-	int band_indices[band_size];
-	int j;
-	for(j = 0; j < band_size; j++){
-		char* dname = get_modis_filename(resolution, bands[j], &band_indices[j]);
-		if(dname == NULL){
-			printf("Band %s is not supported for %s resolution\n", bands[j], resolution);
-			return NULL;
-		}
-		printf("dname: %s\n", dname);
-		strcpy(&dnames[j], dname);
-	}
-	
-	
-	//Get total data size
-	printf("Get total data size\n");
-	int k;
-	int m;
-	int total_size = 0;
-	for(m = 0; m < band_size; m++){
-		for(k = 0; k < num_groups; k++){
-			char* name = names[k];
-			const char* d_arr[] = {instrument, name, resolution, d_fields, dnames[m]};
-			char* dataset_name;
-			concat_by_sep(&dataset_name, d_arr, "/", strlen(instrument) + strlen(name) + strlen(resolution) + strlen(d_fields) + strlen(dnames[m]), 5);
-			hsize_t* curr_dim = af_read_size(file, dataset_name);
-			if(curr_dim == NULL){
-				continue;
-			}
-			total_size += curr_dim[1]*curr_dim[2];
-		}
-	}
-	
-	double* result_data = calloc(total_size, sizeof(double));
-	int start_point = 0;
-	
-	//Start reading data
-	int n;
-	for(n = 0; n < band_size; n++){
-		int file_size;
-		double * MODIS_rad = get_modis_rad_by_band(file, resolution, &dnames[n], &band_indices[n], &file_size);
-		memcpy(&result_data[start_point], MODIS_rad, file_size);
-		start_point += file_size;
-	}
-	
-	if(total_size == start_point){
-		printf("Final size validated\n");
-	}
-	
-	*size = total_size;
-	
-	return result_data;
-}
-
-double* get_modis_rad_by_band(hid_t file, char* resolution, char* d_name, int* band_index, int* size){
-	printf("Reading MODIS rad by band\n");
-	char* instrument = "MODIS";
-	char* d_fields = "Data_Fields";
-	//Get all granule file names
-	printf("Retrieving granule group names\n");
-	hid_t group = H5Gopen(file, instrument, H5P_DEFAULT);
-	if(group < 0){
-		printf("Group not found\n");
-		return NULL;
-	}
-	hsize_t num_groups;
-	herr_t err = H5Gget_num_objs(group, &num_groups);
-	char* names[(int)num_groups][50];
-	int i;
-	for(i = 0; i < num_groups; i++){
-		char* name = malloc(50*sizeof(char));
-		H5Gget_objname_by_idx(group, (hsize_t)i, name, 50);
-		strcpy(&names[i], name);
-		free(name);
-	}
-	
-	//Get total data size
-	printf("Get total data size\n");
-	int k;
-	int total_size = 0;
-	for(k = 0; k < num_groups; k++){
-		char* name = names[k];
-		const char* d_arr[] = {instrument, name, resolution, d_fields, d_name};
-		char* dataset_name;
-		concat_by_sep(&dataset_name, d_arr, "/", strlen(instrument) + strlen(name) + strlen(resolution) + strlen(d_fields) + strlen(d_name), 5);
-		hsize_t* curr_dim = af_read_size(file, dataset_name);
-		if(curr_dim == NULL){
-			continue;
-		}
-		total_size += curr_dim[1]*curr_dim[2];
-	}
-	
-	//Allocate data size
-	double* result_data = calloc(total_size, sizeof(double));
-	
-	//Retreving data
-	int h;
-	int curr_size = 0;
-	int read_first = -1;
-	for(h = 0; h < num_groups; h++){
-		double* data;
-		//Path formation
-		char* name = names[h];
-		const char* d_arr[] = {instrument, name, resolution, d_fields, d_name};
-		char* dataset_name;
-		concat_by_sep(&dataset_name, d_arr, "/", strlen(instrument) + strlen(name) + strlen(resolution) + strlen(d_fields) + strlen(d_name), 5);
-		printf("granule_name: %s\n", name);
-		data = af_read(file, dataset_name);
-		if(data == NULL){
-			continue;
-		} 
-		hsize_t* curr_dim = af_read_size(file, dataset_name);
-		int band_length = curr_dim[1] * curr_dim[2];
-		int read_offset = (*band_index)*band_length;
-		memcpy(&result_data[curr_size], &data[read_offset], band_length*sizeof(double));
-		curr_size += band_length;
-		free(data);
-	}
-	*size = curr_size;
-	
-	assert(curr_size == total_size);
-	printf("Size validated\n");
-	
-	return result_data;
-}
-
-double* get_modis_lat(hid_t file, char* resolution, char* d_name, int* size){
-	printf("Reading MODIS lat\n");
-	//Path variables
-	char* instrument = "MODIS";
-	char* d_fields = "Data_Fields";
-	char* location = "Geolocation";
-	char* lat = "Latitude";
-	
-	//Get all granule file names
-	printf("Retrieving granule group names\n");
-	hid_t group = H5Gopen(file, instrument, H5P_DEFAULT);
-	if(group < 0){
-		printf("Group not found\n");
-		return NULL;
-	}
-	hsize_t num_groups;
-	herr_t err = H5Gget_num_objs(group, &num_groups);
-	char* names[(int)num_groups][50];
-	int i;
-	for(i = 0; i < num_groups; i++){
-		char* name = malloc(50*sizeof(char));
-		H5Gget_objname_by_idx(group, (hsize_t)i, name, 50);
-		strcpy(&names[i], name);
-		free(name);
-	}
-	
-	int h;
-	double* lat_data;
-	double curr_lat_size;
-	int read_first = -1;
-	for(h = 0; h < num_groups; h++){
-		//Path formation
-		char* name = names[h];
-		const char* d_arr[] = {name, resolution, d_fields, d_name};
-		char* dataset_name;
-		concat_by_sep(&dataset_name, d_arr, "/", strlen(name) + strlen(resolution) + strlen(d_fields) + strlen(d_name), 4);
-		memmove(&dataset_name[0], &dataset_name[1], strlen(dataset_name));
-		//Check if dataset exists first
-		printf("granule_name: %s\n", name);
-		htri_t status = H5Lexists(group, dataset_name, H5P_DEFAULT);
-		if(status <= 0){
-			printf("Dataset does not exist\n");
-			continue;
-		}
-		
-		const char* lat_arr[] = {instrument, name, resolution, location, lat};
-		char* lat_dataset_name;
-		concat_by_sep(&lat_dataset_name, lat_arr, "/", strlen(instrument) + strlen(name) + strlen(resolution) + strlen(location) + strlen(lat), 5);
-		
-		if(read_first < 0){
-			curr_lat_size = dim_sum(af_read_size(file, lat_dataset_name), 2);
-			lat_data = af_read(file, lat_dataset_name);
-			read_first = 1;
-		}
-		else{
-			//retrieve next set of data and it's dimention
-			double* adding_lat = af_read(file, lat_dataset_name);
-			double new_lat_size = dim_sum(af_read_size(file, lat_dataset_name), 2);
-			
-			//Reallocating arrays of data
-			lat_data = realloc(lat_data, sizeof(double)*(curr_lat_size + new_lat_size));
-			memcpy(&lat_data[(int)curr_lat_size], adding_lat, sizeof(double)*new_lat_size);
-			curr_lat_size += new_lat_size;
-			
-			free(adding_lat);
-		}
-	}
-	*size = curr_lat_size;
-	
-	if(lat_data != NULL){
-	printf("test_lat_data: %f\n", lat_data[0]);
-	printf("test_lat_data: %f\n", lat_data[2748620]);
-	printf("test_lat_data: %f\n", lat_data[5510780]);
-	}
-	
-	return lat_data;
-}
-
-double* get_modis_long(hid_t file, char* resolution, char* d_name, int* size){
-	printf("Reading MODIS long\n");
-	//Path variables
-	char* instrument = "MODIS";
-	char* d_fields = "Data_Fields";
-	char* location = "Geolocation";
-	char* longitude = "Longitude";
-	
-	//Get all granule file names
-	printf("Retrieving granule group names\n");
-	hid_t group = H5Gopen(file, instrument, H5P_DEFAULT);
-	if(group < 0){
-		printf("Group not found\n");
-		return NULL;
-	}
-	hsize_t num_groups;
-	herr_t err = H5Gget_num_objs(group, &num_groups);
-	char* names[(int)num_groups][50];
-	int i;
-	for(i = 0; i < num_groups; i++){
-		char* name = malloc(50*sizeof(char));
-		H5Gget_objname_by_idx(group, (hsize_t)i, name, 50);
-		strcpy(&names[i], name);
-		free(name);
-	}
-	
-	int h;
-	int valid_granule_count = 0;
-	double* long_data;
-	double curr_long_size;
-	int read_first = -1;
-	for(h = 0; h < num_groups; h++){
-		//Path formation
-		char* name = names[h];
-		const char* d_arr[] = {name, resolution, d_fields, d_name};
-		char* dataset_name;
-		concat_by_sep(&dataset_name, d_arr, "/", strlen(name) + strlen(resolution) + strlen(d_fields) + strlen(d_name), 4);
-		memmove(&dataset_name[0], &dataset_name[1], strlen(dataset_name));
-		//Check if dataset exists first
-		printf("granule_name: %s\n", name);
-		htri_t status = H5Lexists(group, dataset_name, H5P_DEFAULT);
-		if(status <= 0){
-			printf("Dataset does not exist\n");
-			continue;
-		}
-		valid_granule_count += 1;
-		const char* long_arr[] = {instrument, name, resolution, location, longitude};
-		char* long_dataset_name;
-		concat_by_sep(&long_dataset_name, long_arr, "/", strlen(instrument) + strlen(name) + strlen(resolution) + strlen(location) + strlen(longitude), 5);
-		
-		if(read_first < 0){
-			curr_long_size = dim_sum(af_read_size(file, long_dataset_name), 2);
-			long_data = af_read(file, long_dataset_name);
-			read_first = 1;
-		}
-		else{
-			//retrieve next set of data and it's dimention
-			double* adding_long = af_read(file, long_dataset_name);
-			double new_long_size = dim_sum(af_read_size(file, long_dataset_name), 2);
-			
-			//Reallocating arrays of data
-			long_data = realloc(long_data, sizeof(double)*(curr_long_size + new_long_size));
-			memcpy(&long_data[(int)curr_long_size], adding_long, sizeof(double)*new_long_size);
-			curr_long_size += new_long_size;
-
-			free(adding_long);
-		}
-	}
-	*size = curr_long_size;
-	
-	if(long_data != NULL){
-		printf("test_long_data: %f\n", long_data[0]);
-		printf("test_long_data: %f\n", long_data[1]);
-		printf("test_long_data: %f\n", long_data[1353]);
-		printf("test_long_data: %f\n", long_data[1354]);
-		printf("test_long_data: %f\n", long_data[2748620]);
-		printf("test_long_data: %f\n", long_data[5510780]);
-	}
-	
-	return long_data;
-}
-
-//geo - 0:not geolocation attributes, 1:lat, 2:long
-double* get_modis_attr(hid_t file, char* resolution, char* d_name, char* attr_name, int geo, void* attr_pt){
-	//Path variables
-	char* instrument = "MODIS";
-	char* d_fields = "Data_Fields";
-	char* location = "Geolocation";
-	
-	//Get one group name, assuming all attributes across granules are the same
-	printf("Retrieving granule group name\n");
-	hid_t group = H5Gopen(file, instrument, H5P_DEFAULT);
-	if(group < 0){
-		printf("Group not found\n");
-		return NULL;
-	}
-	hsize_t num_groups;
-	herr_t err = H5Gget_num_objs(group, &num_groups);
-	char* rad_dataset_name;
-	char* name = malloc(50*sizeof(char));
-	int h;
-	for(h = 0; h < num_groups; h++){
-		H5Gget_objname_by_idx(group, (hsize_t)h, name, 50);
-		const char* arr[] = {instrument, name, resolution, d_fields, d_name};
-		//Dataset name parsing
-		concat_by_sep(&rad_dataset_name, arr, "/", strlen(instrument) + strlen(name) + strlen(resolution) + strlen(d_fields) + strlen(d_name) + 5, 5);
-		memmove(&rad_dataset_name[0], &rad_dataset_name[1], strlen(rad_dataset_name));
-		htri_t status = H5Lexists(group, rad_dataset_name, H5P_DEFAULT);
-		if(status <= 0){
-			printf("Dataset does not exist\n");
-			continue;
-		}
-		else{
-			break;
-		}
-		
-	}
-	
-	if(geo == 1){
-		char* lat = "Latitude";
-		const char* arr[] = {instrument, name, resolution, location, lat};
-		concat_by_sep(&rad_dataset_name, arr, "/", strlen(instrument) + strlen(name) + strlen(resolution) + strlen(location) + strlen(lat) + 5, 5);
-	}
-	else if(geo == 2){
-		char* longitude = "Longitude";
-		const char* arr[] = {instrument, name, resolution, location, longitude};
-		concat_by_sep(&rad_dataset_name, arr, "/", strlen(instrument) + strlen(name) + strlen(resolution) + strlen(location) + strlen(longitude) + 5, 5);
-	}
-	
-	//Get attribute 	
-	hid_t attr = H5Aopen_by_name(file, rad_dataset_name, attr_name, H5P_DEFAULT, H5P_DEFAULT);
-	if(attr < 0){
-		printf("Attribute %s does not exists\n", attr_name);
-	}
-	hid_t attr_type = H5Aget_type(attr);
-	if(strcmp(attr_name, "units") == 0){
-		attr_pt = malloc(sizeof(char) * 50);
-		H5Aread(attr, attr_type, attr_pt);
-	}
-	else if(strcmp(attr_name, "_FillValue") == 0){
-		attr_pt = malloc(sizeof(float));
-		H5Aread(attr, attr_type, attr_pt);
-	}
-	else if(strcmp(attr_name, "valid_min") == 0){
-		attr_pt = malloc(sizeof(float));
-		H5Aread(attr, attr_type, attr_pt);
-	}
-	H5Aclose(attr);
-	
-	return attr_pt;
-	
-}
-
-char* get_modis_filename(char* resolution, char* band, int* band_index){
-	if(strcmp(resolution, "_1KM") == 0){
-		int i;
-		for(i = 0; i < 15; i++){
-			if(strcmp(band, km_1_ref_list[i]) == 0){
-				*band_index = i;
-				return "EV_1KM_RefSB";
-			}
-		}
-		int j;
-		for(j = 0; j < 16; j++){
-			if(strcmp(band, kme_1_list[j]) == 0){
-				*band_index = j;
-				return "EV_1KM_Emissive";
-			}
-		}
-		int k;
-		for(k = 0;k < 2; k++){
-			if(strcmp(band, m_250_list[k]) == 0){
-				*band_index = k;
-				return "EV_250_Aggr1km_RefSB";
-			}
-		}
-		int a;
-		for(a = 0; a < 5; a++){
-			if(strcmp(band, m_500_list[a]) == 0){
-				*band_index = a;
-				return "EV_500_Aggr1km_RefSB";
-			}
-		}
-		return NULL; 
-	}
-	else if(strcmp(resolution, "_250m") == 0){
-		int i;
-		for(i = 0; i < 2; i++){
-			if(strcmp(band, m_250_list[i]) == 0){
-				*band_index = i;
-				return "EV_250_RefSB";
-			}
-		}
-		return NULL;
-	}
-	else if(strcmp(resolution, "_500m") == 0){
-		int i;
-		for(i = 0; i < 5; i++){
-			if(strcmp(band, m_500_list[i]) == 0){
-				*band_index = i;
-				return "EV_500_RefSB";
-			}
-		}
-		int j;
-		for(j = 0; j < 2; j++){
-			if(strcmp(band, m_250_list[j]) == 0){
-				*band_index = j;
-				return "EV_250_Aggr500_RefSB";
-			}
-		}
-		return NULL;
-	}
-}
-
-double* get_ceres_rad(hid_t file, char* camera, char* d_name, int* size){
-	printf("Reading CERES radiance\n");
-	//Path variables
-	char* instrument = "CERES";
-	char* rad = "Radiances";
-	//Get all granule file names
-	printf("Retrieving granule group names\n");
-	hid_t group = H5Gopen(file, instrument, H5P_DEFAULT);
-	if(group < 0){
-		printf("Group not found\n");
-		return NULL;
-	}
-	hsize_t num_groups;
-	herr_t err = H5Gget_num_objs(group, &num_groups);
-	char* names[(int)num_groups][50];
-	int i;
-	for(i = 0; i < num_groups; i++){
-		char* name = malloc(50*sizeof(char));
-		H5Gget_objname_by_idx(group, (hsize_t)i, name, 50);
-		strcpy(&names[i], name);
-		free(name);
-	}
-	int h;
-	double* data;
-	double curr_size;
-	int read_first = -1;
-	for(h = 0; h < num_groups; h++){
-		//Path formation
-		char* name = names[h];
-		const char* d_arr[] = {instrument, name, camera, rad, d_name};
-		char* dataset_name;
-		concat_by_sep(&dataset_name, d_arr, "/", strlen(instrument) + strlen(name) + strlen(camera) + strlen(rad) + strlen(d_name) + 5, 5);
-		printf("granule_name: %s\n", name);
-		if(read_first < 0){
-			data = af_read(file, dataset_name);
-			if(data == NULL){
-				continue;
-			}
-			curr_size = dim_sum(af_read_size(file, dataset_name), 1); 
-			read_first = 1;
-		}
-		else{
-			//retrieve next set of data and it's dimention
-			double* adding_data = af_read(file, dataset_name);
-			if(adding_data == NULL){
-				continue;
-			}
-			double new_d_size = dim_sum(af_read_size(file, dataset_name), 1);
-			//Reallocating arrays of data
-			data = realloc(data, sizeof(double)*(curr_size + new_d_size));
-			memcpy(&data[(int)curr_size], adding_data, sizeof(double)*new_d_size);
-			curr_size += new_d_size;
-			
-			free(adding_data);
-		}
-	}
-	*size = curr_size;
-	
-	//Print statements to verify data's existence	
-	if(data != NULL){
-		printf("test data: %f\n", data[0]);
-		printf("test_data: %f\n", data[1]);
-		printf("test data: %f\n", data[2]);
-	}	
-	return data;
-}
-
-double* get_ceres_lat(hid_t file, char* camera, char* d_name, int* size){
-	printf("Reading CERES lat\n");
-	//Path variables
-	char* instrument = "CERES";
-	char* rad = "Radiances";
-	char* tp = "Time_and_Position";
-	char* lat = "Latitude";
-	
-	//Get all granule file names
-	printf("Retrieving granule group names\n");
-	hid_t group = H5Gopen(file, instrument, H5P_DEFAULT);
-	if(group < 0){
-		printf("Group not found\n");
-		return NULL;
-	}
-	hsize_t num_groups;
-	herr_t err = H5Gget_num_objs(group, &num_groups);
-	char* names[(int)num_groups][50];
-	int i;
-	for(i = 0; i < num_groups; i++){
-		char* name = malloc(50*sizeof(char));
-		H5Gget_objname_by_idx(group, (hsize_t)i, name, 50);
-		strcpy(&names[i], name);
-		free(name);
-	}
-	int h;
-	double* lat_data;
-	double curr_lat_size;
-	int read_first = -1;
-	for(h = 0; h < num_groups; h++){
-		//Path formation
-		char* name = names[h];
-		const char* d_arr[] = {name, camera, rad, d_name};
-		char* dataset_name;
-		concat_by_sep(&dataset_name, d_arr, "/", strlen(name) + strlen(camera) + strlen(rad) + strlen(d_name), 4);
-		memmove(&dataset_name[0], &dataset_name[1], strlen(dataset_name));
-		//Check if dataset exists first
-		printf("granule_name: %s\n", name);
-		htri_t status = H5Lexists(group, dataset_name, H5P_DEFAULT);
-		if(status <= 0){
-			printf("Dataset does not exist\n");
-			continue;
-		}
-		
-		const char* lat_arr[] = {instrument, name, camera, tp, lat};
-		char* lat_dataset_name;
-		concat_by_sep(&lat_dataset_name, lat_arr, "/", strlen(instrument) + strlen(name) + strlen(camera) + strlen(tp) + strlen(lat) + 5, 5);
-		
-		if(read_first < 0){
-			curr_lat_size = dim_sum(af_read_size(file, lat_dataset_name), 1);
-			lat_data = af_read(file, lat_dataset_name);
-			read_first = 1;
-		}
-		else{
-			//retrieve next set of data and it's dimention
-			double* adding_lat = af_read(file, lat_dataset_name);
-			double new_lat_size = dim_sum(af_read_size(file, lat_dataset_name), 1);
-			
-			//Reallocating arrays of data
-			lat_data = realloc(lat_data, sizeof(double)*(curr_lat_size + new_lat_size));
-			memcpy(&lat_data[(int)curr_lat_size], adding_lat, sizeof(double)*new_lat_size);
-			curr_lat_size += new_lat_size;
-			
-			free(adding_lat);
-		}
-	}
-	*size = curr_lat_size;
-	//Print statements to verify data's existence
-	if(lat_data != NULL){
-		printf("test_lat_data: %f\n", lat_data[0]);
-		printf("test_lat_data: %f\n", lat_data[1]);
-		printf("test_lat_data: %f\n", lat_data[2]);
-	}
-	
-	return lat_data;
-}
-
-double* get_ceres_long(hid_t file, char* camera, char* d_name, int* size){
-	printf("Reading CERES long\n");
-	//Path variables
-	char* instrument = "CERES";
-	char* rad = "Radiances";
-	char* tp = "Time_and_Position";
-	char* longitude = "Longitude";
-	
-	//Get all granule file names
-	printf("Retrieving granule group names\n");
-	hid_t group = H5Gopen(file, instrument, H5P_DEFAULT);
-	if(group < 0){
-		printf("Group not found\n");
-		return NULL;
-	}
-	hsize_t num_groups;
-	herr_t err = H5Gget_num_objs(group, &num_groups);
-	char* names[(int)num_groups][50];
-	int i;
-	for(i = 0; i < num_groups; i++){
-		char* name = malloc(50*sizeof(char));
-		H5Gget_objname_by_idx(group, (hsize_t)i, name, 50);
-		strcpy(&names[i], name);
-		free(name);
-	}
-	int h;
-	double* long_data;
-	double curr_long_size;
-	int read_first = -1;
-	for(h = 0; h < num_groups; h++){
-		//Path formation
-		char* name = names[h];
-		const char* d_arr[] = {name, camera, rad, d_name};
-		char* dataset_name;
-		concat_by_sep(&dataset_name, d_arr, "/", strlen(name) + strlen(camera) + strlen(rad) + strlen(d_name), 4);
-		memmove(&dataset_name[0], &dataset_name[1], strlen(dataset_name));
-		//Check if dataset exists first
-		printf("granule_name: %s\n", name);
-		htri_t status = H5Lexists(group, dataset_name, H5P_DEFAULT);
-		if(status <= 0){
-			printf("Dataset does not exist\n");
-			continue;
-		}
-		
-		const char* long_arr[] = {instrument, name, camera, tp, longitude};
-		char* long_dataset_name;
-		concat_by_sep(&long_dataset_name, long_arr, "/", strlen(instrument) + strlen(name) + strlen(camera) + strlen(tp) + strlen(longitude) + 5, 5);
-		
-		if(read_first < 0){
-			curr_long_size = dim_sum(af_read_size(file, long_dataset_name), 1);
-			long_data = af_read(file, long_dataset_name);
-			read_first = 1;
-		}
-		else{
-			//retrieve next set of data and it's dimention
-			double* adding_long = af_read(file, long_dataset_name);
-			double new_long_size = dim_sum(af_read_size(file, long_dataset_name), 1);
-			//Reallocating arrays of data
-			long_data = realloc(long_data, sizeof(double)*(curr_long_size + new_long_size));
-			memcpy(&long_data[(int)curr_long_size], adding_long, sizeof(double)*new_long_size);
-			curr_long_size += new_long_size;
-
-			free(adding_long);
-		}
-	}
-	*size = curr_long_size;
-	
-	if(long_data != NULL){
-	printf("test_long_data: %f\n", long_data[0]);
-	printf("test_long_data: %f\n", long_data[1]);
-	printf("test_long_data: %f\n", long_data[2]);
-	}
-	
-	return long_data;
-}
-
-double* get_mop_rad(hid_t file, int* size){
-	printf("Reading MOPITT radiance\n");
-	//Path variables
-	char* instrument = "MOPITT";
-	char* d_field = "Data_Fields";
-	char* rad = "MOPITTRadiances";
-	//Get all granule file names
-	printf("Retrieving granule group names\n");
-	hid_t group = H5Gopen(file, instrument, H5P_DEFAULT);
-	if(group < 0){
-		printf("Group not found\n");
-		return NULL;
-	}
-	hsize_t num_groups;
-	herr_t err = H5Gget_num_objs(group, &num_groups);
-	char* names[(int)num_groups][50];
-	int i;
-	for(i = 0; i < num_groups; i++){
-		char* name = malloc(50*sizeof(char));
-		H5Gget_objname_by_idx(group, (hsize_t)i, name, 50);
-		strcpy(&names[i], name);
-		free(name);
-	}
-	int h;
-	double* data;
-	double curr_size;
-	int read_first = -1;
-	for(h = 0; h < num_groups; h++){
-		//Path formation
-		char* name = names[h];
-		const char* d_arr[] = {instrument, name, d_field, rad};
-		char* dataset_name;
-		concat_by_sep(&dataset_name, d_arr, "/", strlen(instrument) + strlen(name) + strlen(d_field) + strlen(rad) + 4, 4);
-		printf("granule_name: %s\n", name);
-		if(read_first < 0){
-			data = af_read(file, dataset_name);
-			if(data == NULL){
-				continue;
-			}
-			curr_size = dim_sum(af_read_size(file, dataset_name), 5); 
-			read_first = 1;
-		}
-		else{
-			//retrieve next set of data and it's dimention
-			double* adding_data = af_read(file, dataset_name);
-			if(adding_data == NULL){
-				continue;
-			}
-			double new_d_size = dim_sum(af_read_size(file, dataset_name), 1);
-			//Reallocating arrays of data
-			data = realloc(data, sizeof(double)*(curr_size + new_d_size));
-			memcpy(&data[(int)curr_size], adding_data, sizeof(double)*new_d_size);
-			curr_size += new_d_size;
-			
-			free(adding_data);
-		}
-	}
-	*size = curr_size;
-	
-	//Print statements to verify data's existence	
-	if(data != NULL){
-		printf("test data: %f\n", data[0]);
-		printf("test_data: %f\n", data[1]);
-		printf("test data: %f\n", data[2]);
-	}	
-	return data;
-}
-
-double* get_mop_lat(hid_t file, int* size){
-	printf("Reading MOPITT lat\n");
-	//Path variables
-	char* instrument = "MOPITT";
-	char* d_field = "Data_Fields";
-	char* rad = "MOPITTRadiances";
-	char* location = "Geolocation";
-	char* lat = "Latitude";
-	
-	//Get all granule file names
-	printf("Retrieving granule group names\n");
-	hid_t group = H5Gopen(file, instrument, H5P_DEFAULT);
-	if(group < 0){
-		printf("Group not found\n");
-		return NULL;
-	}
-	hsize_t num_groups;
-	herr_t err = H5Gget_num_objs(group, &num_groups);
-	char* names[(int)num_groups][50];
-	int i;
-	for(i = 0; i < num_groups; i++){
-		char* name = malloc(50*sizeof(char));
-		H5Gget_objname_by_idx(group, (hsize_t)i, name, 50);
-		strcpy(&names[i], name);
-		free(name);
-	}
-	
-	int h;
-	double* lat_data;
-	double curr_lat_size;
-	int read_first = -1;
-	for(h = 0; h < num_groups; h++){
-		//Path formation
-		char* name = names[h];
-		const char* d_arr[] = {name, d_field, rad};
-		char* dataset_name;
-		concat_by_sep(&dataset_name, d_arr, "/", strlen(name) + strlen(d_field) + strlen(rad), 3);
-		memmove(&dataset_name[0], &dataset_name[1], strlen(dataset_name));
-		//Check if dataset exists first
-		printf("granule_name: %s\n", name);
-		htri_t status = H5Lexists(group, dataset_name, H5P_DEFAULT);
-		if(status <= 0){
-			printf("Dataset does not exist\n");
-			continue;
-		}
-		const char* lat_arr[] = {instrument, name, location, lat};
-		char* lat_dataset_name;
-		concat_by_sep(&lat_dataset_name, lat_arr, "/", strlen(instrument) + strlen(name) + strlen(location) + strlen(lat) + 4, 4);
-		
-		if(read_first < 0){
-			curr_lat_size = dim_sum(af_read_size(file, lat_dataset_name), 3);
-			lat_data = af_read(file, lat_dataset_name);
-			read_first = 1;
-		}
-		else{
-			//retrieve next set of data and it's dimention
-			double* adding_lat = af_read(file, lat_dataset_name);
-			double new_lat_size = dim_sum(af_read_size(file, lat_dataset_name), 3);
-			//Reallocating arrays of data
-			lat_data = realloc(lat_data, sizeof(double)*(curr_lat_size + new_lat_size));
-			memcpy(&lat_data[(int)curr_lat_size], adding_lat, sizeof(double)*new_lat_size);
-			curr_lat_size += new_lat_size;
-
-			free(adding_lat);
-		}
-	}
-	*size = curr_lat_size;
-	//Print statements to verify data's existence
-	if(lat_data != NULL){
-		printf("test_lat_data: %f\n", lat_data[0]);
-		printf("test_lat_data: %f\n", lat_data[1]);
-		printf("test_lat_data: %f\n", lat_data[2]);
-	}
-	
-	return lat_data;
-}
-
-double* get_mop_long(hid_t file, int* size){
-	printf("Reading MOPITT longitude\n");
-	//Path variables
-	char* instrument = "MOPITT";
-	char* d_field = "Data_Fields";
-	char* rad = "MOPITTRadiances";
-	char* location = "Geolocation";
-	char* longitude = "Longitude";
-	
-	//Get all granule file names
-	printf("Retrieving granule group names\n");
-	hid_t group = H5Gopen(file, instrument, H5P_DEFAULT);
-	if(group < 0){
-		printf("Group not found\n");
-		return NULL;
-	}
-	hsize_t num_groups;
-	herr_t err = H5Gget_num_objs(group, &num_groups);
-	char* names[(int)num_groups][50];
-	int i;
-	for(i = 0; i < num_groups; i++){
-		char* name = malloc(50*sizeof(char));
-		H5Gget_objname_by_idx(group, (hsize_t)i, name, 50);
-		strcpy(&names[i], name);
-		free(name);
-	}
-	
-	int h;
-	double* long_data;
-	double curr_long_size;
-	int read_first = -1;
-	for(h = 0; h < num_groups; h++){
-		//Path formation
-		char* name = names[h];
-		const char* d_arr[] = {name, d_field, rad};
-		char* dataset_name;
-		concat_by_sep(&dataset_name, d_arr, "/", strlen(name) + strlen(d_field) +strlen(rad) + 3, 3);
-		memmove(&dataset_name[0], &dataset_name[1], strlen(dataset_name));
-		//Check if dataset exists first
-		printf("granule_name: %s\n", name);
-		htri_t status = H5Lexists(group, dataset_name, H5P_DEFAULT);
-		if(status <= 0){
-			printf("Dataset does not exist\n");
-			continue;
-		}
-		
-		const char* long_arr[] = {instrument, name, location, longitude};
-		char* long_dataset_name;
-		concat_by_sep(&long_dataset_name, long_arr, "/", strlen(instrument) + strlen(name) + strlen(location) + strlen(longitude) + 4, 4);
-		
-		if(read_first < 0){
-			curr_long_size = dim_sum(af_read_size(file, long_dataset_name), 3);
-			long_data = af_read(file, long_dataset_name);
-			read_first = 1;
-		}
-		else{
-			//retrieve next set of data and it's dimention
-			double* adding_long = af_read(file, long_dataset_name);
-			double new_long_size = dim_sum(af_read_size(file, long_dataset_name), 3);
-			//Reallocating arrays of data
-			long_data = realloc(long_data, sizeof(double)*(curr_long_size + new_long_size));
-			memcpy(&long_data[(int)curr_long_size], adding_long, sizeof(double)*new_long_size);
-			curr_long_size += new_long_size;
-
-			free(adding_long);
-		}
-	}
-	*size = curr_long_size;
-	//Print statements to verify data's existence
-	if(long_data != NULL){
-		printf("test_long_data: %f\n", long_data[0]);
-		printf("test_long_data: %f\n", long_data[1]);
-		printf("test_long_data: %f\n", long_data[2]);
-	}
-	return long_data;
-}
-
-double* get_ast_rad(hid_t file, char* subsystem, char* d_name, int*size){
-	printf("Reading ASTER radiance\n");
-	//Path variables
-	char* instrument = "ASTER";
-	//Get all granule file names
-	printf("Retrieving granule group names\n");
-	hid_t group = H5Gopen(file, instrument, H5P_DEFAULT);
-	if(group < 0){
-		printf("Group not found\n");
-		return NULL;
-	}
-	hsize_t num_groups;
-	herr_t err = H5Gget_num_objs(group, &num_groups);
-	char* names[(int)num_groups][50];
-	int i;
-	for(i = 0; i < num_groups; i++){
-		char* name = malloc(50*sizeof(char));
-		H5Gget_objname_by_idx(group, (hsize_t)i, name, 50);
-		strcpy(&names[i], name);
-		free(name);
-	}
-	int h;
-	double* data;
-	double curr_size;
-	int read_first = -1;
-	for(h = 0; h < num_groups; h++){
-		//Path formation
-		char* name = names[h];
-		const char* d_arr[] = {instrument, name, subsystem, d_name};
-		char* dataset_name;
-		concat_by_sep(&dataset_name, d_arr, "/", strlen(instrument) + strlen(name) + strlen(subsystem) + strlen(d_name) + 5, 4);
-		printf("granule_name: %s\n", name);
-		if(read_first < 0){
-			data = af_read(file, dataset_name);
-			if(data == NULL){
-				continue;
-			}
-			curr_size = dim_sum(af_read_size(file, dataset_name), 2); 
-			read_first = 1;
-		}
-		else{
-			//retrieve next set of data and its dimention
-			double* adding_data = af_read(file, dataset_name);
-			if(adding_data == NULL){
-				continue;
-			}
-			double new_d_size = dim_sum(af_read_size(file, dataset_name), 2);
-			//Reallocating arrays of data
-			data = realloc(data, sizeof(double)*(curr_size + new_d_size));
-			memcpy(&data[(int)curr_size], adding_data, sizeof(double)*new_d_size);
-			curr_size += new_d_size;
-			
-			free(adding_data);
-		}
-	}
-	*size = curr_size;
-	
-	//Print statements to verify data's existence
-	if(data != NULL){
-		printf("test data: %f\n", data[0]);
-		printf("test_data: %f\n", data[1]);
-		printf("test data: %f\n", data[2]);
-	}	
-	
-	return data;
-}
-
-double* get_ast_lat(hid_t file, char* subsystem, char* d_name, int*size){
-	printf("Reading ASTER lat\n");
-	//Path variables
-	char* instrument = "ASTER";
-	char* location = "Geolocation";
-	char* lat = "Latitude";
-	//Get all granule file names
-	printf("Retrieving granule group names\n");
-	hid_t group = H5Gopen(file, instrument, H5P_DEFAULT);
-	if(group < 0){
-		printf("Group not found\n");
-		return NULL;
-	}
-	hsize_t num_groups;
-	herr_t err = H5Gget_num_objs(group, &num_groups);
-	char* names[(int)num_groups][50];
-	int i;
-	for(i = 0; i < num_groups; i++){
-		char* name = malloc(50*sizeof(char));
-		H5Gget_objname_by_idx(group, (hsize_t)i, name, 50);
-		strcpy(&names[i], name);
-		free(name);
-	}
-	int h;
-	double* lat_data;
-	double curr_lat_size;
-	int read_first = -1;
-	for(h = 0; h < num_groups; h++){
-		//Path formation
-		char* name = names[h];
-		const char* d_arr[] = {name, subsystem, d_name};
-		char* dataset_name;
-		concat_by_sep(&dataset_name, d_arr, "/", strlen(name) + strlen(subsystem) + strlen(d_name) + 4, 3);
-		memmove(&dataset_name[0], &dataset_name[1], strlen(dataset_name));
-		//Check if dataset exists first
-		printf("granule_name: %s\n", name);
-		htri_t status = H5Lexists(group, dataset_name, H5P_DEFAULT);
-		if(status <= 0){
-			printf("Dataset does not exist\n");
-			continue;
-		}
-		const char* lat_arr[] = {instrument, name, subsystem, location, lat};
-		char* lat_dataset_name;
-		concat_by_sep(&lat_dataset_name, lat_arr, "/", strlen(instrument) + strlen(name) + strlen(subsystem) + strlen(location) + strlen(lat) + 5, 5);
-		if(read_first < 0){
-			curr_lat_size = dim_sum(af_read_size(file, lat_dataset_name), 2);
-			lat_data = af_read(file, lat_dataset_name);
-			read_first = 1;
-		}
-		else{
-			//retrieve next set of data and it's dimention
-			double* adding_lat = af_read(file, lat_dataset_name);
-			double new_lat_size = dim_sum(af_read_size(file, lat_dataset_name), 2);
-			//Reallocating arrays of data
-			lat_data = realloc(lat_data, sizeof(double)*(curr_lat_size + new_lat_size));
-			memcpy(&lat_data[(int)curr_lat_size], adding_lat, sizeof(double)*new_lat_size);
-			curr_lat_size += new_lat_size;
-
-			free(adding_lat);
-		}
-	}
-	*size = curr_lat_size;
-	//Print statements to verify data's existence
-	if(lat_data != NULL){	
-		printf("test_lat_data: %f\n", lat_data[0]);
-		printf("test_lat_data: %f\n", lat_data[1]);
-		printf("test_lat_data: %f\n", lat_data[2]);
-	}
-	return lat_data;
-}
-
-double* get_ast_long(hid_t file, char* subsystem, char* d_name, int* size){
-	printf("Reading ASTER long\n");
-	//Path variables
-	char* instrument = "ASTER";
-	char* location = "Geolocation";
-	char* longitude = "Longitude";
-	//Get all granule file names
-	printf("Retrieving granule group names\n");
-	hid_t group = H5Gopen(file, instrument, H5P_DEFAULT);
-	if(group < 0){
-		printf("Group not found\n");
-		return NULL;
-	}
-	hsize_t num_groups;
-	herr_t err = H5Gget_num_objs(group, &num_groups);
-	char* names[(int)num_groups][50];
-	int i;
-	for(i = 0; i < num_groups; i++){
-		char* name = malloc(50*sizeof(char));
-		H5Gget_objname_by_idx(group, (hsize_t)i, name, 50);
-		strcpy(&names[i], name);
-		free(name);
-	}
-	int h;
-	double* long_data;
-	double curr_long_size;
-	int read_first = -1;
-	for(h = 0; h < num_groups; h++){
-		//Path formation
-		char* name = names[h];
-		const char* d_arr[] = {name, subsystem, d_name};
-		char* dataset_name;
-		concat_by_sep(&dataset_name, d_arr, "/", strlen(name) + strlen(subsystem) + strlen(d_name) + 4, 3);
-		memmove(&dataset_name[0], &dataset_name[1], strlen(dataset_name));
-		//Check if dataset exists first
-		printf("granule_name: %s\n", name);
-		htri_t status = H5Lexists(group, dataset_name, H5P_DEFAULT);
-		if(status <= 0){
-			printf("Dataset does not exist\n");
-			continue;
-		}
-		const char* long_arr[] = {instrument, name, subsystem, location, longitude};
-		char* long_dataset_name;
-		concat_by_sep(&long_dataset_name, long_arr, "/", strlen(instrument) + strlen(name) + strlen(subsystem) + strlen(location) + strlen(longitude) + 5, 5);
-		if(read_first < 0){
-			curr_long_size = dim_sum(af_read_size(file, long_dataset_name), 2);
-			long_data = af_read(file, long_dataset_name);
-			read_first = 1;
-		}
-		else{
-			//retrieve next set of data and it's dimention
-			double* adding_long = af_read(file, long_dataset_name);
-			double new_long_size = dim_sum(af_read_size(file, long_dataset_name), 2);
-			//Reallocating arrays of data
-			long_data = realloc(long_data, sizeof(double)*(curr_long_size + new_long_size));
-			memcpy(&long_data[(int)curr_long_size], adding_long, sizeof(double)*new_long_size);
-			curr_long_size += new_long_size;
-
-			free(adding_long);
-		}
-	}
-	*size = curr_long_size;
-	//Print statements to verify data's existence
-	if(long_data != NULL){
-		printf("test_long_data: %f\n", long_data[0]);
-		printf("test_long_data: %f\n", long_data[1]);
-		printf("test_long_data: %f\n", long_data[2]);
-	}
-	
-	return long_data;
-}
-
-hsize_t* af_read_size(hid_t file, char* dataset_name){
-	hid_t dataset = H5Dopen2(file, dataset_name, H5P_DEFAULT);
-	if(dataset < 0){
-		printf("Dataset open error\n");
-		return NULL; 
-	}
-	hid_t dataspace = H5Dget_space(dataset);
-	if(dataspace < 0){
-		printf("Dataspace open error\n");
-		return NULL;	
-	}
-	const int ndims = H5Sget_simple_extent_ndims(dataspace);
-	hsize_t* dims = malloc(sizeof(hsize_t) * ndims);
-	H5Sget_simple_extent_dims(dataspace, dims, NULL);
-	H5Dclose(dataset);	
-	H5Sclose(dataspace);
-	return dims;
-}
-
-double* af_read(hid_t file, char* dataset_name){
-	hid_t dataset = H5Dopen2(file, dataset_name, H5P_DEFAULT);
-	if(dataset < 0){
-		printf("Dataset open error\n");
-		return NULL; 
-	}
-	hid_t dataspace = H5Dget_space(dataset);
-	if(dataspace < 0){
-		printf("Dataspace open error\n");
-		return NULL;	
-	}
-	
-	const int ndims = H5Sget_simple_extent_ndims(dataspace);
-	hsize_t dims[ndims];
-	H5Sget_simple_extent_dims(dataspace, dims, NULL);
-	hid_t memspace = H5Screate_simple(ndims,dims,NULL);
-	hid_t dtype = H5Dget_type(dataset);
-	hid_t ndtype = H5Tget_native_type(dtype, H5T_DIR_DESCEND);
-	if(strstr(dataset_name, "ASTER") != NULL && strstr(dataset_name, "Geolocation") != NULL){
-		//Special case for ASTER geolocation because they are 64bit floating point numbers
-		double* data = calloc ( dim_sum(dims, sizeof(dims)/sizeof(hsize_t)) , sizeof(double) );
-		herr_t status = H5Dread(dataset, ndtype, memspace, memspace, H5P_DEFAULT, data);
-		H5Dclose(dataset);	
-		H5Sclose(dataspace);
-		H5Tclose(dtype);
-		H5Tclose(ndtype);
-		if(status < 0){
-			printf("read error: %d\n", status);
-		}
-		return data;
-	}
-	else{
-		float* data = calloc ( dim_sum(dims, sizeof(dims)/sizeof(hsize_t)) , sizeof(ndtype) );
-		double* converted_data = calloc ( dim_sum(dims, sizeof(dims)/sizeof(hsize_t)) , sizeof(double) );
-		herr_t status = H5Dread(dataset, ndtype, memspace, memspace, H5P_DEFAULT, data);
-		int i;
-		for(i=0;i < dim_sum(dims, sizeof(dims)/sizeof(hsize_t)); i++){
-			converted_data[i] = (double) data[i];
-		}
-		free(data);
-		H5Dclose(dataset);	
-		H5Sclose(dataspace);
-		H5Tclose(dtype);
-		H5Tclose(ndtype);
-		if(status < 0){
-			printf("read error: %d\n", status);
-		}
-		return converted_data;
-	}
-}
-
-int af_write_misr_on_modis(hid_t output_file, double* misr_out, double* modis, int modis_size, int misr_size){
-	//Create datafield group
-	hid_t group_id = H5Gcreate2(output_file, "/Data_Fields", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-	
-	//Write MODIS first
-	hsize_t modis_dim[3];
-	modis_dim[0] = 15;
-	modis_dim[1] = 1354;
-	modis_dim[2] = (modis_size)/15/1354;
-	hid_t modis_dataspace = H5Screate_simple(3, modis_dim, NULL);
-	hid_t	modis_datatype = H5Tcopy(H5T_NATIVE_DOUBLE);
-    herr_t  modis_status = H5Tset_order(modis_datatype, H5T_ORDER_LE);  
-    hid_t modis_dataset = H5Dcreate2(output_file, "/Data_Fields/modis_rad", modis_datatype, modis_dataspace,H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-    modis_status = H5Dwrite(modis_dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, modis);
-    H5Sclose(modis_dataspace);
-	H5Tclose(modis_datatype);
-	H5Dclose(modis_dataset);
-    if(modis_status < 0){
-    	printf("MODIS write error\n");
-    	return -1;
-	}
-    
-    //Write 
-    hsize_t misr_dim[2];
-	misr_dim[0] = (misr_size) / 1354;
-	misr_dim[1] = 1354;
-	hid_t misr_dataspace = H5Screate_simple(2, misr_dim, NULL);
-	hid_t misr_datatype = H5Tcopy(H5T_NATIVE_DOUBLE);
-    herr_t misr_status = H5Tset_order(misr_datatype, H5T_ORDER_LE);  
-    hid_t misr_dataset = H5Dcreate2(output_file, "/Data_Fields/misr_out", misr_datatype, misr_dataspace,H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-    misr_status = H5Dwrite(misr_dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, misr_out);
-    H5Sclose(misr_dataspace);
-	H5Tclose(misr_datatype);
-	H5Dclose(misr_dataset);
-	if(misr_status < 0){
-		printf("MISR write error\n");
-		return -1;
-	}
-	
-	return 1;
-	
-}
-
-int af_write_mm_geo(hid_t output_file, int geo_flag, double* geo_data, int geo_size){
-	//Check if geolocation group exists
-	herr_t status = H5Gget_objinfo(output_file, "/Geolocation", 0, NULL);
-	if(status != 0){
-		hid_t group_id = H5Gcreate2(output_file, "/Geolocation", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-	}
-	char* d_name;
-	if(geo_flag == 0){
-		d_name = "/Geolocation/Latitude";
-	}
-	else if(geo_flag == 1){
-		d_name = "/Geolocation/Longitude";
-	}
-	hsize_t     geo_dim[2];
-	geo_dim[0] = (geo_size) / 1354;
-	geo_dim[1] = 1354;
-	hid_t geo_dataspace = H5Screate_simple(2, geo_dim, NULL);
-	hid_t geo_datatype = H5Tcopy(H5T_NATIVE_DOUBLE);
-    herr_t geo_status = H5Tset_order(geo_datatype, H5T_ORDER_LE);  
-    hid_t geo_dataset = H5Dcreate2(output_file, d_name, geo_datatype, geo_dataspace,H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-    status = H5Dwrite(geo_dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, geo_data);
-    H5Sclose(geo_dataspace);
-	H5Tclose(geo_datatype);
-	H5Dclose(geo_dataset);
-	
-	if(geo_status < 0){
-		printf("Geo Data write error\n");
-		return -1;
-	}
-	return 1;
-}
-
-hid_t af_open(char* file_path){
-	hid_t f = H5Fopen(file_path, H5F_ACC_RDONLY, H5P_DEFAULT);
-	return f;
-}
-
-herr_t af_close(hid_t file){
-	herr_t ret = H5Fclose(file);
-	return ret;
-}
-
-/*int main (int argc, char *argv[]){
-	//Preset filename here for easy testing 
-	char* file_path = "/projects/TDataFus/kent/temp/40-orbit-file/Jun15.2/TERRA_BF_L1B_O69365_F000_V000.h5";
-	hid_t file;
-	argv[1] = file_path;
-	if(argc < 3){
-		printf("Usage: %s filename instrument_name extra_arguments\n", argv[0]);
-		return 0;
-	}
-	else if(strcmp(argv[2], "MISR") == 0){
-		if(argc < 6){
-			printf("MISR Usage: %s filename MISR camera_angle resolution(H/L) radiance\n", argv[0]);
-			return 0; 
-		}
-		else{
-			//MISR input requirements fulfilled 
-			//Open file
-			file = af_open(file_path);
-			if(file < 0){
-				printf("File not found\n");
-				return -1;
-			}
-						
-			int d_size = 0;
-			int* data_pt = &d_size;
-			double* data = get_misr_rad(file, argv[3], argv[4], argv[5], data_pt);
-			printf("Data size: %d\n", *data_pt);
-			
-			int lat_size = 0;
-			int* lat_pt = &lat_size;
-			double* lat_data = get_misr_lat(file, argv[4], lat_pt);
-			printf("Lat size: %d\n", *lat_pt);
-			
-			int long_size = 0;
-			int* long_pt = &long_size;
-			double* long_data = get_misr_long(file, argv[4], long_pt);
-			printf("Long size: %d\n", *long_pt);
-			
-			if(data != NULL && lat_data != NULL, long_data != NULL){
-				printf("MISR Data retrieval successful\n");
-			}
-			else{
-				printf("MISR Data retrieval failed\n");
-			}
-			
-			printf("Retrieving MISR attributes\n");
-			void* unit_attr;
-			unit_attr = get_misr_attr(file, argv[3], argv[4], argv[5], "Units", 0, unit_attr);
-			printf("Unit attr: %s\n", (char*)unit_attr);
-			void* fill_attr;
-			fill_attr = get_misr_attr(file, argv[3], argv[4], argv[5], "_FillValue", 0, fill_attr);
-			printf("FillValue: %f\n", *(float*) fill_attr);
-			void* lat_attr;
-			lat_attr = get_misr_attr(file, argv[3], argv[4], argv[5], "units", 1, lat_attr);
-			printf("lat_units: %s\n", (char*)lat_attr);
-			void* long_attr;
-			long_attr = get_misr_attr(file, argv[3], argv[4], argv[5], "units", 2, long_attr);
-			printf("long_units: %s\n", (char*)long_attr);
-			
-			herr_t ret = af_close(file);
-		}
-	}
-	else if(strcmp(argv[2], "MODIS") == 0){
-		if(argc < 4){
-			printf("MODIS Usage: %s filename MODIS resolution(1KM/500m/250m)\n", argv[0]);
-		}
-		else{
-			file = af_open(file_path);
-			if(file < 0){
-				printf("File not found\n");
-				return -1;
-			}
-			char* resolution = argv[3];
-			char* d_name = "";
-			if(strcmp(resolution, "1KM") == 0){
-				resolution = "_1KM";
-				d_name = "EV_1KM_RefSB";
-			}
-			else if(strcmp(resolution, "250M") == 0){
-				resolution = "_250m";
-				d_name = "EV_250_RefSB";
-			}
-			else if(strcmp(resolution, "500M") == 0){
-				resolution = "_500m";
-				d_name = "EV_500_RefSB";
-			}
-			else{
-				printf("Wrong resolution, choose from 1KM, 500M or 250M\n");
-			}
-			
-			int data_size = 0;
-			int* data_pt = &data_size;
-			double* data = get_modis_rad(file, resolution, d_name, data_pt);
-			printf("Data size: %d\n", *data_pt);
-			
-			int lat_size = 0;
-			int* lat_pt = &lat_size;
-			double* lat_data = get_modis_lat(file, resolution, d_name, lat_pt);
-			printf("Lat size: %d\n", *lat_pt);
-			
-			int long_size = 0;
-			int* long_pt = &long_size;
-			double* long_data = get_modis_long(file, resolution, d_name, long_pt);
-			printf("Long size: %d\n", *long_pt);
-
-			
-			if(data != NULL && lat_data != NULL, long_data != NULL){
-				printf("MODIS retrieval successful\n");
-			}
-			else{
-				printf("MODIS retrieval failed\n");
-			}
-			
-		
-			printf("Retrieving MODIS attributes\n");
-			void* unit_attr;
-			unit_attr = get_modis_attr(file, resolution, d_name, "units", 0, unit_attr);
-			void* fill_attr;
-			fill_attr = get_modis_attr(file, resolution, d_name, "_FillValue", 0, fill_attr);
-			void* min_attr;
-			min_attr = get_modis_attr(file, resolution, d_name, "valid_min", 0, min_attr);
-			void* lat_attr;
-			lat_attr = get_modis_attr(file, resolution, d_name, "units", 1, lat_attr);
-			void* long_attr;
-			long_attr = get_modis_attr(file, resolution, d_name, "units", 2, long_attr);
-			printf("Unit attr: %s\n", (char*)unit_attr);
-			printf("FillValue: %f\n", *(float*) fill_attr);
-			printf("valid_min: %f\n", *(float*) min_attr);
-			printf("lat unit: %s\n", (char*) lat_attr);
-			printf("long unit: %s\n", (char*) long_attr); 
-			
-			herr_t ret = af_close(file);
-		}
-	}
-	else if(strcmp(argv[2], "CERES") == 0){
-		if(argc < 6){
-			printf("CERES Usage: %s filename CERES camera radiance(LW/SW/WN/TOT) filtered/unfiltered(F/U)");
-		}
-		else{
-				file = af_open(file_path);
-				if(file < 0){
-					printf("File not found\n");
-					return -1;
-				}
-				char* d_name = calloc(30, sizeof(char));
-				if(strcmp(argv[5], "F") == 0){
-					char* f = "_Filtered";
-					char* r = "_Radiance";
-					strcpy(d_name, argv[4]);
-					strncat(d_name, f, strlen(f));
-					strncat(d_name, r, strlen(r));
-				}
-				else{
-					char* r = "_Radiance";
-					strcpy(d_name, argv[4]);
-					strncat(d_name, r, strlen(r));
-				}
-				
-				int data_size = 0;
-				int* data_pt = &data_size;
-				double* data = get_ceres_rad(file, argv[3], d_name, data_pt);
-				printf("Data size: %d\n", *data_pt);
-				
-				int lat_size = 0;
-				int* lat_pt = &lat_size;
-				double* lat_data = get_ceres_lat(file, argv[3], d_name, lat_pt);
-				printf("Lat size: %d\n", *lat_pt);
-
-				int long_size = 0;
-				int* long_pt = &long_size;
-				double* long_data = get_ceres_long(file, argv[3], d_name, long_pt);
-				printf("Long size: %d\n", *long_pt);
-				
-				herr_t ret = af_close(file);
-		}
-	}
-	else if(strcmp(argv[2], "MOPITT") == 0){
-		file = af_open(file_path);
-		if(file < 0){
-			printf("File not found\n");
-			return -1;
-		}
-		int data_size = 0;
-		int* data_pt = &data_size;
-		double* data = get_mop_rad(file, data_pt);
-		printf("Data size: %d\n", *data_pt);
-		
-		int lat_size = 0;
-		int* lat_pt = &lat_size;
-		double* lat_data = get_mop_lat(file, lat_pt);
-		printf("Lat size: %d\n", *lat_pt);
-
-		int long_size = 0;
-		int* long_pt = &long_size;
-		double* long_data = get_mop_long(file, long_pt);
-		printf("Long size: %d\n", *long_pt);
-		
-		herr_t ret = af_close(file);
-	}
-	else if(strcmp(argv[2], "ASTER") == 0){
-		if(argc < 5){
-			printf("ASTER Usage: %s filename ASTER subsystem(TIR/VNIR/SWIR) dataset_name\n");
-		}
-		else{
-				file = af_open(file_path);
-				if(file < 0){
-					printf("File not found\n");
-					return -1;
-				}
-				
-				int data_size = 0;
-				int* data_pt = &data_size;
-				double* data = get_ast_rad(file, argv[3], argv[4], data_pt);
-				if(data != NULL){
-					printf("Data size: %d\n", *data_pt);	
-				}
-				int lat_size = 0;
-				int* lat_pt = &lat_size;
-				double* lat_data = get_ast_lat(file, argv[3], argv[4], lat_pt);
-				printf("Lat size: %d\n", *lat_pt);
-				
-				int long_size = 0;
-				int* long_pt = &long_size;
-				printf("going into ast_long\n");
-				double* long_data = get_ast_long(file, argv[3], argv[4], long_pt);
-				printf("Long size: %d\n", *long_pt);	
-				
-				herr_t ret = af_close(file);	
-		}
-	}
-	else{
-		printf("Invalid instrument\n");
-	}
-	
-	return 0;
-}*/
-
-//Helper Functions
-//String helper
-void concat_by_sep(char** source, const char** w, char* sep, size_t length, int arr_size){
-	int i;
-	*source = calloc(length+20, sizeof(char));
-	for(i = 0; i < arr_size; i++){
-		if(i == 0){
-			strncpy(*source, sep, strlen(sep));
-			strncat(*source, w[i], strlen(w[i]));
-		}
-		else{
-			strncat(*source, sep, strlen(sep));
-			strncat(*source, w[i], strlen(w[i]));
-		}
-	}
-}
-//Summing up dimensions
-double dim_sum(hsize_t* dims, int arr_len){
-	double sum = 0.0;
-	int i;
-	for(i = 0; i < arr_len; i++){
-		if(i == 0){
-			sum = (double)dims[i];
-		}
-		else{
-			sum *= (double)dims[i];
-		}
-	}
-	return sum;
-}
-//Turning float to double
-double float_to_double(float f){
-	char buf[50];
-	sprintf(buf, "%.7g", f);
-	return atof(buf);
-}
-
-double misr_averaging(double window[16]){
-	double sum = 0.0;
-	double count = 0.0;
-	int i;
-	for(i = 0; i < 16; i++){
-		if(window[i] < 0){
-			return -999.0;
-		}
-		else{
-			sum += window[i];
-			count += 1;
-		}
-	}
-	return sum/count;
-}
+/*
+
+
+    AUTHOR:
+        Yat Long Lo
+
+    EMAIL:
+        yllo2@illinois.edu
+
+
+*/
+
+#include "io.h"
+#include <hdf5.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <string.h>
+#include <assert.h>
+#define FALSE   0
+
+//Band constants for MODIS
+char* m_250_list[2] = {"1", "2"};
+char* m_500_list[5] = {"3", "4", "5", "6", "7"};
+char* km_1_ref_list[15] = {"8", "9", "10", "11", "12", "13L", "13H", "14L", "14H", "15", "16", "17", "18", "19", "26"};
+char* kme_1_list[16] = {"20", "21", "22", "23", "24", "25", "27", "28", "29", "30", "31", "32", "33", "34", "35", "36"};
+
+
+af_real* get_misr_rad(hid_t file, char* camera_angle, char* resolution, char* radiance, int* size){
+	return get_misr_rad_blocks(file, camera_angle, resolution, radiance, 0, -1, size);
+}
+
+//Radiance of blocks [first_block, first_block + num_blocks) only, all blocks when num_blocks < 0
+af_real* get_misr_rad_blocks(hid_t file, char* camera_angle, char* resolution, char* radiance, int first_block, int num_blocks, int* size){
+	//Path to dataset proccessing 
+	int down_sampling = 0;
+	char* instrument = "MISR";
+	char* d_fields = "Data_Fields";
+	
+	//Dataset name parsing
+	char rad_dataset_name[AF_PATH_LEN];
+	snprintf(rad_dataset_name, AF_PATH_LEN, "/%s/%s/%s/%s", instrument, camera_angle, d_fields, radiance);
+	//Check for correct specification
+	if(strcmp(camera_angle, "AN") != 0 && strcmp(radiance, "Red_Radiance") != 0 && strcmp(resolution, "H") == 0){
+		printf("Error: Your specification does not support high resolution.\n");
+		return NULL;
+	}
+	else if((strcmp(camera_angle, "AN") == 0 || strcmp(radiance, "Red_Radiance") == 0) && strcmp(resolution, "L") == 0){
+		//Downsampling has to be done
+		down_sampling = 1;
+	}
+	
+	printf("Reading MISR\n");
+	/*Dimensions - 180 blocks, 512 x 2048 ordered in 1D Array*/
+	//Retrieve radiance dataset and its shape from the catalog
+	af_dataset_info* info = af_catalog_lookup(file, rad_dataset_name);
+	if(info == NULL){
+		printf("Dataset does not exist\n");
+		return NULL;
+	}
+	if(num_blocks < 0){
+		first_block = 0;
+		num_blocks = info->dims[0];
+	}
+	if(down_sampling == 1){
+		//Stream the 275m cube one block at a time straight into the 1.1km grid
+		printf("Undergoing downsampling\n");
+		af_real* down_data = af_read_block_average_range(file, rad_dataset_name, 4, first_block, num_blocks, size);
+		if(down_data == NULL){
+			return NULL;
+		}
+		printf("Downsampling done\n");
+		printf("rad_data: %f\n", down_data[0]);
+		return down_data;
+	}
+	
+	af_real* data;
+	if(first_block == 0 && num_blocks == info->dims[0]){
+		data = af_read(file, rad_dataset_name);
+		*size = info->num_points;
+	}
+	else{
+		data = af_read_slab(file, rad_dataset_name, 0, first_block, num_blocks, size);
+	}
+	if(data == NULL){
+		return NULL;
+	}
+	printf("Reading successful\n");
+	printf("rad_data: %f\n", data[0]);
+	return data;	
+}
+
+af_real* get_misr_lat(hid_t file, char* resolution, int* size){
+	//Path to dataset proccessing 
+	char* instrument = "MISR";
+	char* location;
+	if(strcmp(resolution, "H") == 0){
+		location = "HRGeolocation";
+	}
+	else{
+		location = "Geolocation";
+	}
+	char* lat = "GeoLatitude";
+	
+	//Dataset names parsing
+	char lat_dataset_name[AF_PATH_LEN];
+	snprintf(lat_dataset_name, AF_PATH_LEN, "/%s/%s/%s", instrument, location, lat);
+	
+	printf("Retrieveing latitude data for MISR\n");
+	//Retrieve latitude dataset and dataspace
+	af_dataset_info* info = af_catalog_lookup(file, lat_dataset_name);
+	if(info == NULL){
+		printf("Dataset does not exist\n");
+		return NULL;
+	}
+	af_real* lat_data = af_read(file, lat_dataset_name);
+	*size = info->num_points;
+	if(lat_data == NULL){
+		return NULL;
+	}
+	printf("lat_data: %f\n", lat_data[0]);
+	return lat_data;
+}
+
+af_real* get_misr_long(hid_t file, char* resolution, int* size){
+	//Path to dataset proccessing 
+	char* instrument = "MISR";
+	char* location;
+	if(strcmp(resolution, "H") == 0){
+		location = "HRGeolocation";
+	}
+	else{
+		location = "Geolocation";
+	}
+	char* longitude = "GeoLongitude";
+	
+	//Dataset names parsing
+	char long_dataset_name[AF_PATH_LEN];
+	snprintf(long_dataset_name, AF_PATH_LEN, "/%s/%s/%s", instrument, location, longitude);
+	
+	printf("Retrieveing longitude data for MISR\n");
+	//Retrieve longitude dataset and dataspace
+	af_dataset_info* info = af_catalog_lookup(file, long_dataset_name);
+	if(info == NULL){
+		printf("Dataset does not exist\n");
+		return NULL;
+	}
+	af_real* long_data = af_read(file, long_dataset_name);
+	*size = info->num_points;
+	if(long_data == NULL){
+		return NULL;
+	}
+	printf("long_data: %f\n", long_data[0]);
+	return long_data;
+}
+
+//geo - 0:not geolocation attributes, 1:lat, 2:long
+void* get_misr_attr(hid_t file, char* camera_angle, char* resolution, char* radiance, char* attr_name, int geo, void* attr_pt){
+	//Path variables
+	char* instrument = "MISR";
+	char* d_fields = "Data_Fields";
+	char* location = "Geolocation";
+
+	//Dataset name parsing
+	char rad_dataset_name[AF_PATH_LEN];
+	if(geo == 0){
+		snprintf(rad_dataset_name, AF_PATH_LEN, "/%s/%s/%s/%s", instrument, camera_angle, d_fields, radiance);
+	}
+	else if(geo == 1){
+		char* lat = "GeoLatitude";
+		snprintf(rad_dataset_name, AF_PATH_LEN, "/%s/%s/%s", instrument, location, lat);
+	}
+	else if(geo == 2){
+		char* longitude = "GeoLongitude";
+		snprintf(rad_dataset_name, AF_PATH_LEN, "/%s/%s/%s", instrument, location, longitude);
+	}
+	else{
+		printf("Wrong geo number");
+		return NULL;
+	}
+	
+	//Get attribute
+	hid_t attr = H5Aopen_by_name(file, rad_dataset_name, attr_name, H5P_DEFAULT, H5P_DEFAULT);
+	if(attr < 0){
+		printf("Attribute %s does not exists\n", attr_name);
+	}
+	hid_t attr_type = H5Aget_type(attr);
+	if(strcmp(attr_name, "Units") == 0 || strcmp(attr_name, "units") == 0){
+		attr_pt = malloc(sizeof(char) * 50);
+		H5Aread(attr, attr_type, attr_pt);
+	}
+	else if(strcmp(attr_name, "_FillValue") == 0){
+		attr_pt = malloc(sizeof(float));
+		H5Aread(attr, attr_type, attr_pt);
+	}
+	H5Aclose(attr);
+	
+	return attr_pt;
+}
+
+af_real* get_modis_rad(hid_t file, char* resolution, char* bands[], int band_size, int* size){
+	printf("Reading MODIS rad\n");
+	
+	//Path variables
+	char* instrument = "MODIS";
+	//Get all granule names from the file catalog
+	int num_groups;
+	char** names = af_catalog_granules(file, instrument, &num_groups);
+	if(names == NULL){
+		printf("Group not found\n");
+		return NULL;
+	}
+	
+	//Get dataset names from bands
+	printf("Retreving dataset names\n");
+	char* dnames[band_size];
+	int band_indices[band_size];
+	int j;
+	for(j = 0; j < band_size; j++){
+		dnames[j] = get_modis_filename(resolution, bands[j], &band_indices[j]);
+		if(dnames[j] == NULL){
+			printf("Band %s is not supported for %s resolution\n", bands[j], resolution);
+			return NULL;
+		}
+		printf("dname: %s\n", dnames[j]);
+	}
+	
+	return modis_read_band_planes(file, resolution, names, num_groups, dnames, band_indices, band_size, size);
+}
+
+af_real* get_modis_rad_by_band(hid_t file, char* resolution, char* d_name, int* band_index, int* size){
+	printf("Reading MODIS rad by band\n");
+	char* instrument = "MODIS";
+	//Get all granule names from the file catalog
+	int num_groups;
+	char** names = af_catalog_granules(file, instrument, &num_groups);
+	if(names == NULL){
+		printf("Group not found\n");
+		return NULL;
+	}
+	
+	return modis_read_band_planes(file, resolution, names, num_groups, &d_name, band_index, 1, size);
+}
+
+//Multi-band read planner - bands are grouped by their source dataset so every granule's dataset is opened once,
+//and only the requested band planes are selected and read straight into their slot of the output cube.
+//Output layout is band major: [band][granule rows x cols] over the granules modis_read_geo returns (those with
+//the first band's data field). A band whose dataset a granule lacks gets -999 there, so every band stays aligned
+//with the geolocation
+af_real* modis_read_band_planes(hid_t file, char* resolution, char** names, int num_groups, char* dnames[], int* band_indices, int band_size, int* size){
+	char* instrument = "MODIS";
+	char* d_fields = "Data_Fields";
+	*size = 0;
+	if(band_size <= 0 || num_groups <= 0){
+		return NULL;
+	}
+	
+	//Group requested bands by source dataset
+	int band_group[band_size];
+	char* group_dnames[band_size];
+	int num_dsets = 0;
+	int j, d;
+	for(j = 0; j < band_size; j++){
+		for(d = 0; d < num_dsets; d++){
+			if(strcmp(group_dnames[d], dnames[j]) == 0){
+				break;
+			}
+		}
+		if(d == num_dsets){
+			group_dnames[num_dsets] = dnames[j];
+			num_dsets += 1;
+		}
+		band_group[j] = d;
+	}
+	
+	//Shape pass - plane size of every granule from its geolocation, 0 for granules the geolocation readers skip
+	printf("Get total data size\n");
+	hsize_t plane_len[num_groups];
+	hsize_t swath_len = 0;
+	int g;
+	for(g = 0; g < num_groups; g++){
+		plane_len[g] = 0;
+		char dataset_name[AF_PATH_LEN];
+		snprintf(dataset_name, AF_PATH_LEN, "/%s/%s/%s/%s/%s", instrument, names[g], resolution, d_fields, dnames[0]);
+		if(af_catalog_lookup(file, dataset_name) == NULL){
+			continue;
+		}
+		snprintf(dataset_name, AF_PATH_LEN, "/%s/%s/%s/Geolocation/Latitude", instrument, names[g], resolution);
+		af_dataset_info* info = af_catalog_lookup(file, dataset_name);
+		if(info != NULL && info->rank == 2){
+			plane_len[g] = info->dims[0] * info->dims[1];
+			swath_len += plane_len[g];
+		}
+	}
+	hsize_t total_size = band_size * swath_len;
+	if(total_size == 0){
+		return NULL;
+	}
+	af_real* result_data = malloc(total_size * sizeof(af_real));
+	if(result_data == NULL){
+		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
+		return NULL;
+	}
+	hsize_t k;
+	for(k = 0; k < total_size; k++){
+		result_data[k] = -999;
+	}
+	
+	//Read pass - one open per granule dataset, one plane selection per requested band
+	hid_t memspace = H5Screate_simple(1, &total_size, NULL);
+	hsize_t granule_offset = 0;
+	for(g = 0; g < num_groups; g++){
+		if(plane_len[g] == 0){
+			continue;
+		}
+		printf("granule_name: %s\n", names[g]);
+		for(d = 0; d < num_dsets; d++){
+			char dataset_name[AF_PATH_LEN];
+			snprintf(dataset_name, AF_PATH_LEN, "/%s/%s/%s/%s/%s", instrument, names[g], resolution, d_fields, group_dnames[d]);
+			af_dataset_info* info = af_catalog_lookup(file, dataset_name);
+			if(info == NULL){
+				continue;
+			}
+			if(info->rank != 3 || info->dims[1] * info->dims[2] != plane_len[g]){
+				printf("%s does not match its geolocation\n", dataset_name);
+				continue;
+			}
+			if(info->type_class != H5T_FLOAT && info->type_class != H5T_INTEGER){
+				printf("Unsupported datatype class: %d\n", info->type_class);
+				continue;
+			}
+			hid_t dataset = H5Dopen2(file, dataset_name, H5P_DEFAULT);
+			if(dataset < 0){
+				printf("Dataset open error\n");
+				continue;
+			}
+			hid_t dataspace = H5Dget_space(dataset);
+			hsize_t* dims = info->dims;
+			for(j = 0; j < band_size; j++){
+				if(band_group[j] != d){
+					continue;
+				}
+				hsize_t f_offset[3] = {band_indices[j], 0, 0};
+				hsize_t f_count[3] = {1, dims[1], dims[2]};
+				hsize_t m_offset = j * swath_len + granule_offset;
+				hsize_t m_count = plane_len[g];
+				H5Sselect_hyperslab(dataspace, H5S_SELECT_SET, f_offset, NULL, f_count, NULL);
+				H5Sselect_hyperslab(memspace, H5S_SELECT_SET, &m_offset, NULL, &m_count, NULL);
+				herr_t status = H5Dread(dataset, af_mem_type_id(AF_REAL_TYPE), memspace, dataspace, H5P_DEFAULT, result_data);
+				if(status < 0){
+					printf("read error: %d\n", status);
+				}
+			}
+			H5Sclose(dataspace);
+			H5Dclose(dataset);
+		}
+		granule_offset += plane_len[g];
+	}
+	H5Sclose(memspace);
+	
+	*size = total_size;
+	printf("Size validated\n");
+	
+	return result_data;
+}
+
+//Geolocation (geo_name: Latitude or Longitude) of the given granules, concatenated in order.
+//Granules without the d_name data field are skipped, as in the radiance readers
+af_real* modis_read_geo(hid_t file, char* resolution, char* d_name, char* geo_name, char** names, int num_groups, int* size){
+	char* instrument = "MODIS";
+	char* d_fields = "Data_Fields";
+	char* location = "Geolocation";
+	
+	//Collect the dataset of every granule, then read them all into one buffer
+	char paths[num_groups > 0 ? num_groups : 1][AF_PATH_LEN];
+	char* dataset_names[num_groups > 0 ? num_groups : 1];
+	int num_datasets = 0;
+	int h;
+	for(h = 0; h < num_groups; h++){
+		//Path formation
+		char* name = names[h];
+		printf("granule_name: %s\n", name);
+		//Check if dataset exists first
+		char dataset_name[AF_PATH_LEN];
+		snprintf(dataset_name, AF_PATH_LEN, "/%s/%s/%s/%s/%s", instrument, name, resolution, d_fields, d_name);
+		if(af_catalog_lookup(file, dataset_name) == NULL){
+			printf("Dataset does not exist\n");
+			continue;
+		}
+		dataset_names[num_datasets] = paths[num_datasets];
+		snprintf(paths[num_datasets], AF_PATH_LEN, "/%s/%s/%s/%s/%s", instrument, name, resolution, location, geo_name);
+		num_datasets += 1;
+	}
+	
+	return af_read_concat(file, dataset_names, num_datasets, size);
+}
+
+//Scan lines of every granule (rows of its geolocation, 0 when the d_name data field is missing).
+//The orbit's MODIS swath is the granules' rows one after another; returns the total
+hsize_t modis_swath_rows(hid_t file, char* resolution, char* d_name, char** names, int num_groups, hsize_t* granule_rows){
+	char* instrument = "MODIS";
+	char* d_fields = "Data_Fields";
+	hsize_t total_rows = 0;
+	int g;
+	for(g = 0; g < num_groups; g++){
+		char dataset_name[AF_PATH_LEN];
+		snprintf(dataset_name, AF_PATH_LEN, "/%s/%s/%s/%s/%s", instrument, names[g], resolution, d_fields, d_name);
+		af_dataset_info* field = af_catalog_lookup(file, dataset_name);
+		snprintf(dataset_name, AF_PATH_LEN, "/%s/%s/%s/Geolocation/Latitude", instrument, names[g], resolution);
+		af_dataset_info* geo = af_catalog_lookup(file, dataset_name);
+		granule_rows[g] = (field != NULL && geo != NULL && geo->rank == 2) ? geo->dims[0] : 0;
+		total_rows += granule_rows[g];
+	}
+	return total_rows;
+}
+
+//Geolocation of swath rows [first_row, first_row + num_rows), which may span several granules
+af_real* modis_read_geo_rows(hid_t file, char* resolution, char* d_name, char* geo_name, char** names, int num_groups, hsize_t first_row, hsize_t num_rows, int* size){
+	char* instrument = "MODIS";
+	hsize_t granule_rows[num_groups > 0 ? num_groups : 1];
+	modis_swath_rows(file, resolution, d_name, names, num_groups, granule_rows);
+	
+	//Shape pass - columns of the first granule in the window, every granule in it must match
+	hsize_t cols = 0;
+	hsize_t start = 0;
+	int g;
+	for(g = 0; g < num_groups; g++){
+		if(granule_rows[g] > 0 && start + granule_rows[g] > first_row && start < first_row + num_rows){
+			char dataset_name[AF_PATH_LEN];
+			snprintf(dataset_name, AF_PATH_LEN, "/%s/%s/%s/Geolocation/%s", instrument, names[g], resolution, geo_name);
+			af_dataset_info* info = af_catalog_lookup(file, dataset_name);
+			if(info == NULL || info->rank != 2 || (cols != 0 && info->dims[1] != cols)){
+				printf("Geolocation %s missing or of a different width\n", dataset_name);
+				return NULL;
+			}
+			cols = info->dims[1];
+		}
+		start += granule_rows[g];
+	}
+	if(num_rows == 0 || cols == 0){
+		*size = 0;
+		return NULL;
+	}
+	
+	af_real* data = malloc(num_rows * cols * sizeof(af_real));
+	if(data == NULL){
+		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
+		return NULL;
+	}
+	//Read pass - the overlap of the window with each granule goes straight to its rows of the output
+	start = 0;
+	for(g = 0; g < num_groups; g++){
+		hsize_t end = start + granule_rows[g];
+		hsize_t lo = first_row > start ? first_row : start;
+		hsize_t hi = first_row + num_rows < end ? first_row + num_rows : end;
+		if(lo < hi){
+			char dataset_name[AF_PATH_LEN];
+			snprintf(dataset_name, AF_PATH_LEN, "/%s/%s/%s/Geolocation/%s", instrument, names[g], resolution, geo_name);
+			hsize_t offset[2] = {lo - start, 0};
+			hsize_t count[2] = {hi - lo, cols};
+			if(af_read_hyperslab_into(file, dataset_name, 2, offset, count, NULL, &data[(lo - first_row) * cols], AF_REAL_TYPE) < 0){
+				free(data);
+				return NULL;
+			}
+		}
+		start = end;
+	}
+	*size = num_rows * cols;
+	return data;
+}
+
+//Band planes of swath rows [first_row, first_row + num_rows), band major like modis_read_band_planes:
+//[band][rows x cols]. Rows of granules without a band's dataset are filled with -999 so they stay
+//aligned with modis_read_geo_rows
+af_real* modis_read_band_rows(hid_t file, char* resolution, char** names, int num_groups, char* dnames[], int* band_indices, int band_size, hsize_t first_row, hsize_t num_rows, int* size){
+	char* instrument = "MODIS";
+	char* d_fields = "Data_Fields";
+	if(band_size <= 0 || num_rows == 0){
+		*size = 0;
+		return NULL;
+	}
+	hsize_t granule_rows[num_groups > 0 ? num_groups : 1];
+	modis_swath_rows(file, resolution, dnames[0], names, num_groups, granule_rows);
+	
+	hsize_t cols = 0;
+	hsize_t start = 0;
+	int g, j;
+	for(g = 0; g < num_groups && cols == 0; g++){
+		if(granule_rows[g] > 0 && start + granule_rows[g] > first_row && start < first_row + num_rows){
+			char dataset_name[AF_PATH_LEN];
+			snprintf(dataset_name, AF_PATH_LEN, "/%s/%s/%s/Geolocation/Latitude", instrument, names[g], resolution);
+			//Granules with scan lines but no usable geolocation leave the width to the next one
+			af_dataset_info* info = af_catalog_lookup(file, dataset_name);
+			if(info != NULL && info->rank == 2){
+				cols = info->dims[1];
+			}
+		}
+		start += granule_rows[g];
+	}
+	if(cols == 0){
+		*size = 0;
+		return NULL;
+	}
+	
+	hsize_t plane = num_rows * cols;
+	af_real* data = malloc(band_size * plane * sizeof(af_real));
+	if(data == NULL){
+		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
+		return NULL;
+	}
+	hsize_t k;
+	for(k = 0; k < band_size * plane; k++){
+		data[k] = -999;
+	}
+	start = 0;
+	for(g = 0; g < num_groups; g++){
+		hsize_t end = start + granule_rows[g];
+		hsize_t lo = first_row > start ? first_row : start;
+		hsize_t hi = first_row + num_rows < end ? first_row + num_rows : end;
+		for(j = 0; j < band_size && lo < hi; j++){
+			char dataset_name[AF_PATH_LEN];
+			snprintf(dataset_name, AF_PATH_LEN, "/%s/%s/%s/%s/%s", instrument, names[g], resolution, d_fields, dnames[j]);
+			af_dataset_info* info = af_catalog_lookup(file, dataset_name);
+			if(info == NULL || info->rank != 3 || info->dims[1] != granule_rows[g] || info->dims[2] != cols){
+				continue;
+			}
+			hsize_t offset[3] = {band_indices[j], lo - start, 0};
+			hsize_t count[3] = {1, hi - lo, cols};
+			if(af_read_hyperslab_into(file, dataset_name, 3, offset, count, NULL, &data[j * plane + (lo - first_row) * cols], AF_REAL_TYPE) < 0){
+				free(data);
+				return NULL;
+			}
+		}
+		start = end;
+	}
+	*size = band_size * plane;
+	return data;
+}
+
+af_real* get_modis_lat(hid_t file, char* resolution, char* d_name, int* size){
+	printf("Reading MODIS lat\n");
+	//Path variables
+	char* instrument = "MODIS";
+	char* lat = "Latitude";
+	
+	//Get all granule names from the file catalog
+	int num_groups;
+	char** names = af_catalog_granules(file, instrument, &num_groups);
+	if(names == NULL){
+		printf("Group not found\n");
+		return NULL;
+	}
+	
+	af_real* lat_data = modis_read_geo(file, resolution, d_name, lat, names, num_groups, size);
+	
+	//Print statements to verify data's existence
+	if(lat_data != NULL){
+		printf("test_lat_data: %f\n", lat_data[0]);
+		if(*size > 2748620){
+			printf("test_lat_data: %f\n", lat_data[2748620]);
+		}
+		if(*size > 5510780){
+			printf("test_lat_data: %f\n", lat_data[5510780]);
+		}
+	}
+	
+	return lat_data;
+}
+
+af_real* get_modis_long(hid_t file, char* resolution, char* d_name, int* size){
+	printf("Reading MODIS long\n");
+	//Path variables
+	char* instrument = "MODIS";
+	char* longitude = "Longitude";
+	
+	//Get all granule names from the file catalog
+	int num_groups;
+	char** names = af_catalog_granules(file, instrument, &num_groups);
+	if(names == NULL){
+		printf("Group not found\n");
+		return NULL;
+	}
+	
+	af_real* long_data = modis_read_geo(file, resolution, d_name, longitude, names, num_groups, size);
+	
+	//Print statements to verify data's existence
+	if(long_data != NULL){
+		printf("test_long_data: %f\n", long_data[0]);
+		if(*size > 1){
+			printf("test_long_data: %f\n", long_data[1]);
+		}
+		if(*size > 1353){
+			printf("test_long_data: %f\n", long_data[1353]);
+		}
+		if(*size > 1354){
+			printf("test_long_data: %f\n", long_data[1354]);
+		}
+		if(*size > 2748620){
+			printf("test_long_data: %f\n", long_data[2748620]);
+		}
+		if(*size > 5510780){
+			printf("test_long_data: %f\n", long_data[5510780]);
+		}
+	}
+	
+	return long_data;
+}
+
+//geo - 0:not geolocation attributes, 1:lat, 2:long
+double* get_modis_attr(hid_t file, char* resolution, char* d_name, char* attr_name, int geo, void* attr_pt){
+	//Path variables
+	char* instrument = "MODIS";
+	char* d_fields = "Data_Fields";
+	char* location = "Geolocation";
+	
+	//Get one group name, assuming all attributes across granules are the same
+	printf("Retrieving granule group name\n");
+	int num_groups;
+	char** names = af_catalog_granules(file, instrument, &num_groups);
+	if(names == NULL){
+		printf("Group not found\n");
+		return NULL;
+	}
+	char rad_dataset_name[AF_PATH_LEN];
+	char* name = NULL;
+	int h;
+	for(h = 0; h < num_groups; h++){
+		//Dataset name parsing
+		snprintf(rad_dataset_name, AF_PATH_LEN, "/%s/%s/%s/%s/%s", instrument, names[h], resolution, d_fields, d_name);
+		if(af_catalog_lookup(file, rad_dataset_name) == NULL){
+			printf("Dataset does not exist\n");
+			continue;
+		}
+		else{
+			name = names[h];
+			break;
+		}
+		
+	}
+	if(name == NULL){
+		return NULL;
+	}
+	
+	if(geo == 1){
+		char* lat = "Latitude";
+		snprintf(rad_dataset_name, AF_PATH_LEN, "/%s/%s/%s/%s/%s", instrument, name, resolution, location, lat);
+	}
+	else if(geo == 2){
+		char* longitude = "Longitude";
+		snprintf(rad_dataset_name, AF_PATH_LEN, "/%s/%s/%s/%s/%s", instrument, name, resolution, location, longitude);
+	}
+	
+	//Get attribute 	
+	hid_t attr = H5Aopen_by_name(file, rad_dataset_name, attr_name, H5P_DEFAULT, H5P_DEFAULT);
+	if(attr < 0){
+		printf("Attribute %s does not exists\n", attr_name);
+	}
+	hid_t attr_type = H5Aget_type(attr);
+	if(strcmp(attr_name, "units") == 0){
+		attr_pt = malloc(sizeof(char) * 50);
+		H5Aread(attr, attr_type, attr_pt);
+	}
+	else if(strcmp(attr_name, "_FillValue") == 0){
+		attr_pt = malloc(sizeof(float));
+		H5Aread(attr, attr_type, attr_pt);
+	}
+	else if(strcmp(attr_name, "valid_min") == 0){
+		attr_pt = malloc(sizeof(float));
+		H5Aread(attr, attr_type, attr_pt);
+	}
+	H5Aclose(attr);
+	
+	return attr_pt;
+	
+}
+
+char* get_modis_filename(char* resolution, char* band, int* band_index){
+	if(strcmp(resolution, "_1KM") == 0){
+		int i;
+		for(i = 0; i < 15; i++){
+			if(strcmp(band, km_1_ref_list[i]) == 0){
+				*band_index = i;
+				return "EV_1KM_RefSB";
+			}
+		}
+		int j;
+		for(j = 0; j < 16; j++){
+			if(strcmp(band, kme_1_list[j]) == 0){
+				*band_index = j;
+				return "EV_1KM_Emissive";
+			}
+		}
+		int k;
+		for(k = 0;k < 2; k++){
+			if(strcmp(band, m_250_list[k]) == 0){
+				*band_index = k;
+				return "EV_250_Aggr1km_RefSB";
+			}
+		}
+		int a;
+		for(a = 0; a < 5; a++){
+			if(strcmp(band, m_500_list[a]) == 0){
+				*band_index = a;
+				return "EV_500_Aggr1km_RefSB";
+			}
+		}
+		return NULL; 
+	}
+	else if(strcmp(resolution, "_250m") == 0){
+		int i;
+		for(i = 0; i < 2; i++){
+			if(strcmp(band, m_250_list[i]) == 0){
+				*band_index = i;
+				return "EV_250_RefSB";
+			}
+		}
+		return NULL;
+	}
+	else if(strcmp(resolution, "_500m") == 0){
+		int i;
+		for(i = 0; i < 5; i++){
+			if(strcmp(band, m_500_list[i]) == 0){
+				*band_index = i;
+				return "EV_500_RefSB";
+			}
+		}
+		int j;
+		for(j = 0; j < 2; j++){
+			if(strcmp(band, m_250_list[j]) == 0){
+				*band_index = j;
+				return "EV_250_Aggr500_RefSB";
+			}
+		}
+		return NULL;
+	}
+}
+
+af_real* get_ceres_rad(hid_t file, char* camera, char* d_name, int* size){
+	return get_ceres_rad_rows(file, camera, d_name, 0, -1, size);
+}
+
+//Rows [first_row, first_row + num_rows) of the granules concatenated along their first axis, all rows when num_rows < 0
+af_real* get_ceres_rad_rows(hid_t file, char* camera, char* d_name, int first_row, int num_rows, int* size){
+	printf("Reading CERES radiance\n");
+	//Path variables
+	char* instrument = "CERES";
+	char* rad = "Radiances";
+	
+	//Get all granule names from the file catalog
+	int num_groups;
+	char** names = af_catalog_granules(file, instrument, &num_groups);
+	if(names == NULL){
+		printf("Group not found\n");
+		return NULL;
+	}
+	
+	//Collect the dataset of every granule, then read the row window of all of them into one buffer
+	char paths[num_groups > 0 ? num_groups : 1][AF_PATH_LEN];
+	char* dataset_names[num_groups > 0 ? num_groups : 1];
+	int num_datasets = 0;
+	int h;
+	for(h = 0; h < num_groups; h++){
+		//Path formation
+		char* name = names[h];
+		printf("granule_name: %s\n", name);
+		dataset_names[num_datasets] = paths[num_datasets];
+		snprintf(paths[num_datasets], AF_PATH_LEN, "/%s/%s/%s/%s/%s", instrument, name, camera, rad, d_name);
+		num_datasets += 1;
+	}
+	
+	af_real* data = af_read_concat_rows(file, dataset_names, num_datasets, first_row, num_rows, size);
+	
+	//Print statements to verify data's existence
+	if(data != NULL){
+		printf("test data: %f\n", data[0]);
+		if(*size > 1){
+			printf("test data: %f\n", data[1]);
+		}
+		if(*size > 2){
+			printf("test data: %f\n", data[2]);
+		}
+	}
+	
+	return data;
+}
+
+af_real* get_ceres_lat(hid_t file, char* camera, char* d_name, int* size){
+	return get_ceres_lat_rows(file, camera, d_name, 0, -1, size);
+}
+
+//Rows [first_row, first_row + num_rows) only, all rows when num_rows < 0
+af_real* get_ceres_lat_rows(hid_t file, char* camera, char* d_name, int first_row, int num_rows, int* size){
+	printf("Reading CERES lat\n");
+	//Path variables
+	char* instrument = "CERES";
+	char* rad = "Radiances";
+	char* tp = "Time_and_Position";
+	char* lat = "Latitude";
+	
+	//Get all granule names from the file catalog
+	int num_groups;
+	char** names = af_catalog_granules(file, instrument, &num_groups);
+	if(names == NULL){
+		printf("Group not found\n");
+		return NULL;
+	}
+	
+	//Collect the dataset of every granule, then read the row window of all of them into one buffer
+	char paths[num_groups > 0 ? num_groups : 1][AF_PATH_LEN];
+	char* dataset_names[num_groups > 0 ? num_groups : 1];
+	int num_datasets = 0;
+	int h;
+	for(h = 0; h < num_groups; h++){
+		//Path formation
+		char* name = names[h];
+		printf("granule_name: %s\n", name);
+		//Check if dataset exists first
+		char dataset_name[AF_PATH_LEN];
+		snprintf(dataset_name, AF_PATH_LEN, "/%s/%s/%s/%s/%s", instrument, name, camera, rad, d_name);
+		if(af_catalog_lookup(file, dataset_name) == NULL){
+			printf("Dataset does not exist\n");
+			continue;
+		}
+		dataset_names[num_datasets] = paths[num_datasets];
+		snprintf(paths[num_datasets], AF_PATH_LEN, "/%s/%s/%s/%s/%s", instrument, name, camera, tp, lat);
+		num_datasets += 1;
+	}
+	
+	af_real* lat_data = af_read_concat_rows(file, dataset_names, num_datasets, first_row, num_rows, size);
+	
+	//Print statements to verify data's existence
+	if(lat_data != NULL){
+		printf("test_lat_data: %f\n", lat_data[0]);
+		if(*size > 1){
+			printf("test_lat_data: %f\n", lat_data[1]);
+		}
+		if(*size > 2){
+			printf("test_lat_data: %f\n", lat_data[2]);
+		}
+	}
+	
+	return lat_data;
+}
+
+af_real* get_ceres_long(hid_t file, char* camera, char* d_name, int* size){
+	return get_ceres_long_rows(file, camera, d_name, 0, -1, size);
+}
+
+//Rows [first_row, first_row + num_rows) only, all rows when num_rows < 0
+af_real* get_ceres_long_rows(hid_t file, char* camera, char* d_name, int first_row, int num_rows, int* size){
+	printf("Reading CERES long\n");
+	//Path variables
+	char* instrument = "CERES";
+	char* rad = "Radiances";
+	char* tp = "Time_and_Position";
+	char* longitude = "Longitude";
+	
+	//Get all granule names from the file catalog
+	int num_groups;
+	char** names = af_catalog_granules(file, instrument, &num_groups);
+	if(names == NULL){
+		printf("Group not found\n");
+		return NULL;
+	}
+	
+	//Collect the dataset of every granule, then read the row window of all of them into one buffer
+	char paths[num_groups > 0 ? num_groups : 1][AF_PATH_LEN];
+	char* dataset_names[num_groups > 0 ? num_groups : 1];
+	int num_datasets = 0;
+	int h;
+	for(h = 0; h < num_groups; h++){
+		//Path formation
+		char* name = names[h];
+		printf("granule_name: %s\n", name);
+		//Check if dataset exists first
+		char dataset_name[AF_PATH_LEN];
+		snprintf(dataset_name, AF_PATH_LEN, "/%s/%s/%s/%s/%s", instrument, name, camera, rad, d_name);
+		if(af_catalog_lookup(file, dataset_name) == NULL){
+			printf("Dataset does not exist\n");
+			continue;
+		}
+		dataset_names[num_datasets] = paths[num_datasets];
+		snprintf(paths[num_datasets], AF_PATH_LEN, "/%s/%s/%s/%s/%s", instrument, name, camera, tp, longitude);
+		num_datasets += 1;
+	}
+	
+	af_real* long_data = af_read_concat_rows(file, dataset_names, num_datasets, first_row, num_rows, size);
+	
+	//Print statements to verify data's existence
+	if(long_data != NULL){
+		printf("test_long_data: %f\n", long_data[0]);
+		if(*size > 1){
+			printf("test_long_data: %f\n", long_data[1]);
+		}
+		if(*size > 2){
+			printf("test_long_data: %f\n", long_data[2]);
+		}
+	}
+	
+	return long_data;
+}
+
+af_real* get_mop_rad(hid_t file, int* size){
+	return get_mop_rad_rows(file, 0, -1, size);
+}
+
+//Rows [first_row, first_row + num_rows) only, all rows when num_rows < 0
+af_real* get_mop_rad_rows(hid_t file, int first_row, int num_rows, int* size){
+	printf("Reading MOPITT radiance\n");
+	//Path variables
+	char* instrument = "MOPITT";
+	char* d_field = "Data_Fields";
+	char* rad = "MOPITTRadiances";
+	
+	//Get all granule names from the file catalog
+	int num_groups;
+	char** names = af_catalog_granules(file, instrument, &num_groups);
+	if(names == NULL){
+		printf("Group not found\n");
+		return NULL;
+	}
+	
+	//Collect the dataset of every granule, then read the row window of all of them into one buffer
+	char paths[num_groups > 0 ? num_groups : 1][AF_PATH_LEN];
+	char* dataset_names[num_groups > 0 ? num_groups : 1];
+	int num_datasets = 0;
+	int h;
+	for(h = 0; h < num_groups; h++){
+		//Path formation
+		char* name = names[h];
+		printf("granule_name: %s\n", name);
+		dataset_names[num_datasets] = paths[num_datasets];
+		snprintf(paths[num_datasets], AF_PATH_LEN, "/%s/%s/%s/%s", instrument, name, d_field, rad);
+		num_datasets += 1;
+	}
+	
+	af_real* data = af_read_concat_rows(file, dataset_names, num_datasets, first_row, num_rows, size);
+	
+	//Print statements to verify data's existence
+	if(data != NULL){
+		printf("test data: %f\n", data[0]);
+		if(*size > 1){
+			printf("test data: %f\n", data[1]);
+		}
+		if(*size > 2){
+			printf("test data: %f\n", data[2]);
+		}
+	}
+	
+	return data;
+}
+
+af_real* get_mop_lat(hid_t file, int* size){
+	return get_mop_lat_rows(file, 0, -1, size);
+}
+
+//Rows [first_row, first_row + num_rows) only, all rows when num_rows < 0
+af_real* get_mop_lat_rows(hid_t file, int first_row, int num_rows, int* size){
+	printf("Reading MOPITT lat\n");
+	//Path variables
+	char* instrument = "MOPITT";
+	char* d_field = "Data_Fields";
+	char* rad = "MOPITTRadiances";
+	char* location = "Geolocation";
+	char* lat = "Latitude";
+	
+	//Get all granule names from the file catalog
+	int num_groups;
+	char** names = af_catalog_granules(file, instrument, &num_groups);
+	if(names == NULL){
+		printf("Group not found\n");
+		return NULL;
+	}
+	
+	//Collect the dataset of every granule, then read the row window of all of them into one buffer
+	char paths[num_groups > 0 ? num_groups : 1][AF_PATH_LEN];
+	char* dataset_names[num_groups > 0 ? num_groups : 1];
+	int num_datasets = 0;
+	int h;
+	for(h = 0; h < num_groups; h++){
+		//Path formation
+		char* name = names[h];
+		printf("granule_name: %s\n", name);
+		//Check if dataset exists first
+		char dataset_name[AF_PATH_LEN];
+		snprintf(dataset_name, AF_PATH_LEN, "/%s/%s/%s/%s", instrument, name, d_field, rad);
+		if(af_catalog_lookup(file, dataset_name) == NULL){
+			printf("Dataset does not exist\n");
+			continue;
+		}
+		dataset_names[num_datasets] = paths[num_datasets];
+		snprintf(paths[num_datasets], AF_PATH_LEN, "/%s/%s/%s/%s", instrument, name, location, lat);
+		num_datasets += 1;
+	}
+	
+	af_real* lat_data = af_read_concat_rows(file, dataset_names, num_datasets, first_row, num_rows, size);
+	
+	//Print statements to verify data's existence
+	if(lat_data != NULL){
+		printf("test_lat_data: %f\n", lat_data[0]);
+		if(*size > 1){
+			printf("test_lat_data: %f\n", lat_data[1]);
+		}
+		if(*size > 2){
+			printf("test_lat_data: %f\n", lat_data[2]);
+		}
+	}
+	
+	return lat_data;
+}
+
+af_real* get_mop_long(hid_t file, int* size){
+	return get_mop_long_rows(file, 0, -1, size);
+}
+
+//Rows [first_row, first_row + num_rows) only, all rows when num_rows < 0
+af_real* get_mop_long_rows(hid_t file, int first_row, int num_rows, int* size){
+	printf("Reading MOPITT longitude\n");
+	//Path variables
+	char* instrument = "MOPITT";
+	char* d_field = "Data_Fields";
+	char* rad = "MOPITTRadiances";
+	char* location = "Geolocation";
+	char* longitude = "Longitude";
+	
+	//Get all granule names from the file catalog
+	int num_groups;
+	char** names = af_catalog_granules(file, instrument, &num_groups);
+	if(names == NULL){
+		printf("Group not found\n");
+		return NULL;
+	}
+	
+	//Collect the dataset of every granule, then read the row window of all of them into one buffer
+	char paths[num_groups > 0 ? num_groups : 1][AF_PATH_LEN];
+	char* dataset_names[num_groups > 0 ? num_groups : 1];
+	int num_datasets = 0;
+	int h;
+	for(h = 0; h < num_groups; h++){
+		//Path formation
+		char* name = names[h];
+		printf("granule_name: %s\n", name);
+		//Check if dataset exists first
+		char dataset_name[AF_PATH_LEN];
+		snprintf(dataset_name, AF_PATH_LEN, "/%s/%s/%s/%s", instrument, name, d_field, rad);
+		if(af_catalog_lookup(file, dataset_name) == NULL){
+			printf("Dataset does not exist\n");
+			continue;
+		}
+		dataset_names[num_datasets] = paths[num_datasets];
+		snprintf(paths[num_datasets], AF_PATH_LEN, "/%s/%s/%s/%s", instrument, name, location, longitude);
+		num_datasets += 1;
+	}
+	
+	af_real* long_data = af_read_concat_rows(file, dataset_names, num_datasets, first_row, num_rows, size);
+	
+	//Print statements to verify data's existence
+	if(long_data != NULL){
+		printf("test_long_data: %f\n", long_data[0]);
+		if(*size > 1){
+			printf("test_long_data: %f\n", long_data[1]);
+		}
+		if(*size > 2){
+			printf("test_long_data: %f\n", long_data[2]);
+		}
+	}
+	
+	return long_data;
+}
+
+af_real* get_ast_rad(hid_t file, char* subsystem, char* d_name, int* size){
+	return get_ast_rad_rows(file, subsystem, d_name, 0, -1, size);
+}
+
+//Rows [first_row, first_row + num_rows) only, all rows when num_rows < 0
+af_real* get_ast_rad_rows(hid_t file, char* subsystem, char* d_name, int first_row, int num_rows, int* size){
+	printf("Reading ASTER radiance\n");
+	//Path variables
+	char* instrument = "ASTER";
+	
+	//Get all granule names from the file catalog
+	int num_groups;
+	char** names = af_catalog_granules(file, instrument, &num_groups);
+	if(names == NULL){
+		printf("Group not found\n");
+		return NULL;
+	}
+	
+	//Collect the dataset of every granule, then read the row window of all of them into one buffer
+	char paths[num_groups > 0 ? num_groups : 1][AF_PATH_LEN];
+	char* dataset_names[num_groups > 0 ? num_groups : 1];
+	int num_datasets = 0;
+	int h;
+	for(h = 0; h < num_groups; h++){
+		//Path formation
+		char* name = names[h];
+		printf("granule_name: %s\n", name);
+		dataset_names[num_datasets] = paths[num_datasets];
+		snprintf(paths[num_datasets], AF_PATH_LEN, "/%s/%s/%s/%s", instrument, name, subsystem, d_name);
+		num_datasets += 1;
+	}
+	
+	af_real* data = af_read_concat_rows(file, dataset_names, num_datasets, first_row, num_rows, size);
+	
+	//Print statements to verify data's existence
+	if(data != NULL){
+		printf("test data: %f\n", data[0]);
+		if(*size > 1){
+			printf("test data: %f\n", data[1]);
+		}
+		if(*size > 2){
+			printf("test data: %f\n", data[2]);
+		}
+	}
+	
+	return data;
+}
+
+af_real* get_ast_lat(hid_t file, char* subsystem, char* d_name, int* size){
+	return get_ast_lat_rows(file, subsystem, d_name, 0, -1, size);
+}
+
+//Rows [first_row, first_row + num_rows) only, all rows when num_rows < 0
+af_real* get_ast_lat_rows(hid_t file, char* subsystem, char* d_name, int first_row, int num_rows, int* size){
+	printf("Reading ASTER lat\n");
+	//Path variables
+	char* instrument = "ASTER";
+	char* location = "Geolocation";
+	char* lat = "Latitude";
+	
+	//Get all granule names from the file catalog
+	int num_groups;
+	char** names = af_catalog_granules(file, instrument, &num_groups);
+	if(names == NULL){
+		printf("Group not found\n");
+		return NULL;
+	}
+	
+	//Collect the dataset of every granule, then read the row window of all of them into one buffer
+	char paths[num_groups > 0 ? num_groups : 1][AF_PATH_LEN];
+	char* dataset_names[num_groups > 0 ? num_groups : 1];
+	int num_datasets = 0;
+	int h;
+	for(h = 0; h < num_groups; h++){
+		//Path formation
+		char* name = names[h];
+		printf("granule_name: %s\n", name);
+		//Check if dataset exists first
+		char dataset_name[AF_PATH_LEN];
+		snprintf(dataset_name, AF_PATH_LEN, "/%s/%s/%s/%s", instrument, name, subsystem, d_name);
+		if(af_catalog_lookup(file, dataset_name) == NULL){
+			printf("Dataset does not exist\n");
+			continue;
+		}
+		dataset_names[num_datasets] = paths[num_datasets];
+		snprintf(paths[num_datasets], AF_PATH_LEN, "/%s/%s/%s/%s/%s", instrument, name, subsystem, location, lat);
+		num_datasets += 1;
+	}
+	
+	af_real* lat_data = af_read_concat_rows(file, dataset_names, num_datasets, first_row, num_rows, size);
+	
+	//Print statements to verify data's existence
+	if(lat_data != NULL){
+		printf("test_lat_data: %f\n", lat_data[0]);
+		if(*size > 1){
+			printf("test_lat_data: %f\n", lat_data[1]);
+		}
+		if(*size > 2){
+			printf("test_lat_data: %f\n", lat_data[2]);
+		}
+	}
+	
+	return lat_data;
+}
+
+af_real* get_ast_long(hid_t file, char* subsystem, char* d_name, int* size){
+	return get_ast_long_rows(file, subsystem, d_name, 0, -1, size);
+}
+
+//Rows [first_row, first_row + num_rows) only, all rows when num_rows < 0
+af_real* get_ast_long_rows(hid_t file, char* subsystem, char* d_name, int first_row, int num_rows, int* size){
+	printf("Reading ASTER long\n");
+	//Path variables
+	char* instrument = "ASTER";
+	char* location = "Geolocation";
+	char* longitude = "Longitude";
+	
+	//Get all granule names from the file catalog
+	int num_groups;
+	char** names = af_catalog_granules(file, instrument, &num_groups);
+	if(names == NULL){
+		printf("Group not found\n");
+		return NULL;
+	}
+	
+	//Collect the dataset of every granule, then read the row window of all of them into one buffer
+	char paths[num_groups > 0 ? num_groups : 1][AF_PATH_LEN];
+	char* dataset_names[num_groups > 0 ? num_groups : 1];
+	int num_datasets = 0;
+	int h;
+	for(h = 0; h < num_groups; h++){
+		//Path formation
+		char* name = names[h];
+		printf("granule_name: %s\n", name);
+		//Check if dataset exists first
+		char dataset_name[AF_PATH_LEN];
+		snprintf(dataset_name, AF_PATH_LEN, "/%s/%s/%s/%s", instrument, name, subsystem, d_name);
+		if(af_catalog_lookup(file, dataset_name) == NULL){
+			printf("Dataset does not exist\n");
+			continue;
+		}
+		dataset_names[num_datasets] = paths[num_datasets];
+		snprintf(paths[num_datasets], AF_PATH_LEN, "/%s/%s/%s/%s/%s", instrument, name, subsystem, location, longitude);
+		num_datasets += 1;
+	}
+	
+	af_real* long_data = af_read_concat_rows(file, dataset_names, num_datasets, first_row, num_rows, size);
+	
+	//Print statements to verify data's existence
+	if(long_data != NULL){
+		printf("test_long_data: %f\n", long_data[0]);
+		if(*size > 1){
+			printf("test_long_data: %f\n", long_data[1]);
+		}
+		if(*size > 2){
+			printf("test_long_data: %f\n", long_data[2]);
+		}
+	}
+	
+	return long_data;
+}
+
+hsize_t* af_read_size(hid_t file, char* dataset_name){
+	//Shape comes from the file catalog, no dataset open needed
+	af_dataset_info* info = af_catalog_lookup(file, dataset_name);
+	if(info == NULL){
+		printf("Dataset open error\n");
+		return NULL; 
+	}
+	hsize_t* dims = malloc(sizeof(hsize_t) * info->rank);
+	memcpy(dims, info->dims, sizeof(hsize_t) * info->rank);
+	return dims;
+}
+
+//Catalog entry of a dataset the readers can convert to af_real, NULL (with a message) otherwise
+static af_dataset_info* af_lookup_readable(hid_t file, char* dataset_name){
+	af_dataset_info* info = af_catalog_lookup(file, dataset_name);
+	if(info == NULL){
+		printf("Dataset open error\n");
+		return NULL;
+	}
+	if(info->type_class != H5T_FLOAT && info->type_class != H5T_INTEGER){
+		printf("Unsupported datatype class: %d\n", info->type_class);
+		return NULL;
+	}
+	return info;
+}
+
+af_real* af_read(hid_t file, char* dataset_name){
+	//Size comes from the file catalog; the dataset is only opened for the read itself
+	af_dataset_info* info = af_lookup_readable(file, dataset_name);
+	if(info == NULL){
+		return NULL; 
+	}
+	af_real* data = malloc(info->num_points * sizeof(af_real));
+	if(data == NULL){
+		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
+		return NULL;
+	}
+	if(af_read_into(file, dataset_name, data, AF_REAL_TYPE) < 0){
+		free(data);
+		return NULL;
+	}
+	return data;
+}
+
+//Typed read into a caller-supplied buffer - HDF5 converts from the file type to mem_type during H5Dread
+herr_t af_read_into(hid_t file, char* dataset_name, void* dest, af_mem_type mem_type){
+	if(af_lookup_readable(file, dataset_name) == NULL){
+		return -1;
+	}
+	hid_t dataset = H5Dopen2(file, dataset_name, H5P_DEFAULT);
+	if(dataset < 0){
+		printf("Dataset open error\n");
+		return -1;
+	}
+	herr_t status = H5Dread(dataset, af_mem_type_id(mem_type), H5S_ALL, H5S_ALL, H5P_DEFAULT, dest);
+	H5Dclose(dataset);
+	if(status < 0){
+		printf("read error: %d\n", status);
+	}
+	return status;
+}
+
+//Windowed read - offset, count and stride are given per dimension (stride may be NULL for contiguous windows)
+af_real* af_read_hyperslab(hid_t file, char* dataset_name, int rank, hsize_t* offset, hsize_t* count, hsize_t* stride){
+	hsize_t total_size = 1;
+	int i;
+	for(i = 0; i < rank; i++){
+		total_size *= count[i];
+	}
+	af_real* data = malloc(total_size * sizeof(af_real));
+	if(data == NULL){
+		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
+		return NULL;
+	}
+	if(af_read_hyperslab_into(file, dataset_name, rank, offset, count, stride, data, AF_REAL_TYPE) < 0){
+		free(data);
+		return NULL;
+	}
+	return data;
+}
+
+//Windowed typed read into a caller-supplied dense buffer of prod(count) elements
+herr_t af_read_hyperslab_into(hid_t file, char* dataset_name, int rank, hsize_t* offset, hsize_t* count, hsize_t* stride, void* dest, af_mem_type mem_type){
+	//Check the window against the dataset extent from the catalog
+	af_dataset_info* info = af_lookup_readable(file, dataset_name);
+	if(info == NULL){
+		return -1;
+	}
+	if(info->rank != rank){
+		printf("Hyperslab rank %d does not match dataset rank %d\n", rank, info->rank);
+		return -1;
+	}
+	int i;
+	for(i = 0; i < rank; i++){
+		hsize_t step = (stride == NULL) ? 1 : stride[i];
+		if(count[i] == 0 || step == 0 || offset[i] + (count[i] - 1) * step >= info->dims[i]){
+			printf("Hyperslab out of bounds in dimension %d\n", i);
+			return -1;
+		}
+	}
+
+	hid_t dataset = H5Dopen2(file, dataset_name, H5P_DEFAULT);
+	if(dataset < 0){
+		printf("Dataset open error\n");
+		return -1;
+	}
+	hid_t dataspace = H5Dget_space(dataset);
+
+	//Select the window in the file and read it into a dense memory space
+	herr_t status = H5Sselect_hyperslab(dataspace, H5S_SELECT_SET, offset, stride, count, NULL);
+	hid_t memspace = H5Screate_simple(rank, count, NULL);
+	if(status >= 0){
+		status = H5Dread(dataset, af_mem_type_id(mem_type), memspace, dataspace, H5P_DEFAULT, dest);
+	}
+	H5Sclose(memspace);
+	H5Sclose(dataspace);
+	H5Dclose(dataset);
+	if(status < 0){
+		printf("read error: %d\n", status);
+	}
+	return status;
+}
+
+//Reads a rank-3 dataset one plane (MISR block) at a time and block averages each plane by factor,
+//so only one full resolution plane is resident at any time
+af_real* af_read_block_average(hid_t file, char* dataset_name, int factor, int* size){
+	af_dataset_info* info = af_catalog_lookup(file, dataset_name);
+	if(info == NULL){
+		printf("Dataset does not exist\n");
+		return NULL;
+	}
+	return af_read_block_average_range(file, dataset_name, factor, 0, info->dims[0], size);
+}
+
+//Block averaging of planes [first_plane, first_plane + num_planes) only
+af_real* af_read_block_average_range(hid_t file, char* dataset_name, int factor, hsize_t first_plane, hsize_t num_planes, int* size){
+	af_dataset_info* info = af_lookup_readable(file, dataset_name);
+	if(info == NULL){
+		return NULL;
+	}
+	if(info->rank != 3){
+		printf("Block averaging needs a rank 3 dataset, got rank %d\n", info->rank);
+		return NULL;
+	}
+	if(factor != 2 && factor != 4 && factor != 8){
+		printf("Unsupported block averaging factor %d\n", factor);
+		return NULL;
+	}
+	if(first_plane + num_planes > info->dims[0]){
+		printf("Planes [%llu, %llu) out of range\n", (unsigned long long)first_plane, (unsigned long long)(first_plane + num_planes));
+		return NULL;
+	}
+	hsize_t planes = num_planes;
+	hsize_t rows = info->dims[1];
+	hsize_t cols = info->dims[2];
+	hsize_t down_plane = (rows/factor) * (cols/factor);
+	
+	hid_t dataset = H5Dopen2(file, dataset_name, H5P_DEFAULT);
+	if(dataset < 0){
+		printf("Dataset open error\n");
+		return NULL;
+	}
+	af_real* down_data = malloc(planes * down_plane * sizeof(af_real));
+	af_real* plane = malloc(rows * cols * sizeof(af_real));
+	if(down_data == NULL || plane == NULL){
+		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
+		free(down_data);
+		free(plane);
+		H5Dclose(dataset);
+		return NULL;
+	}
+	hid_t dataspace = H5Dget_space(dataset);
+	hsize_t count[3] = {1, rows, cols};
+	hid_t memspace = H5Screate_simple(3, count, NULL);
+	herr_t status = 0;
+	hsize_t p;
+	for(p = 0; p < planes && status >= 0; p++){
+		hsize_t offset[3] = {first_plane + p, 0, 0};
+		status = H5Sselect_hyperslab(dataspace, H5S_SELECT_SET, offset, NULL, count, NULL);
+		if(status >= 0){
+			status = H5Dread(dataset, af_mem_type_id(AF_REAL_TYPE), memspace, dataspace, H5P_DEFAULT, plane);
+		}
+		if(status >= 0){
+			blockAverage(plane, &down_data[p * down_plane], 1, rows, cols, factor);
+		}
+	}
+	H5Sclose(memspace);
+	H5Sclose(dataspace);
+	H5Dclose(dataset);
+	free(plane);
+	if(status < 0){
+		printf("read error: %d\n", status);
+		free(down_data);
+		return NULL;
+	}
+	*size = planes * down_plane;
+	return down_data;
+}
+
+//Reads [start, start + length) along one axis (MISR blocks, MODIS bands, scan lines) and the full extent of the others
+af_real* af_read_slab(hid_t file, char* dataset_name, int axis, hsize_t start, hsize_t length, int* size){
+	af_dataset_info* info = af_catalog_lookup(file, dataset_name);
+	if(info == NULL){
+		printf("Dataset open error\n");
+		return NULL;
+	}
+	const int ndims = info->rank;
+	hsize_t* dims = info->dims;
+	if(axis < 0 || axis >= ndims){
+		printf("Axis %d out of range for dataset rank %d\n", axis, ndims);
+		return NULL;
+	}
+
+	hsize_t offset[ndims];
+	hsize_t count[ndims];
+	int i;
+	for(i = 0; i < ndims; i++){
+		offset[i] = 0;
+		count[i] = dims[i];
+	}
+	offset[axis] = start;
+	count[axis] = length;
+	af_real* data = af_read_hyperslab(file, dataset_name, ndims, offset, count, NULL);
+	if(data != NULL){
+		*size = dim_sum(count, ndims);
+	}
+	return data;
+}
+
+//Two-phase concatenation of granule datasets - a shape pass sizes the result, then every dataset
+//is read straight into its offset of the one preallocated buffer. Missing datasets are skipped.
+af_real* af_read_concat(hid_t file, char** dataset_names, int num_datasets, int* size){
+	return af_read_concat_rows(file, dataset_names, num_datasets, 0, -1, size);
+}
+
+//Rows [first_row, first_row + num_rows) of the datasets stacked along their first axis, all rows when
+//num_rows < 0. Only the overlap of the window with each granule is read, straight to its offset in the output
+af_real* af_read_concat_rows(hid_t file, char** dataset_names, int num_datasets, int first_row, int num_rows, int* size){
+	//Shape pass - answered by the file catalog
+	af_dataset_info* infos[num_datasets > 0 ? num_datasets : 1];
+	hsize_t total_rows = 0;
+	int i;
+	for(i = 0; i < num_datasets; i++){
+		infos[i] = af_catalog_lookup(file, dataset_names[i]);
+		if(infos[i] == NULL){
+			printf("Dataset does not exist\n");
+			continue;
+		}
+		if(infos[i]->type_class != H5T_FLOAT && infos[i]->type_class != H5T_INTEGER){
+			printf("Unsupported datatype class: %d\n", infos[i]->type_class);
+			infos[i] = NULL;
+			continue;
+		}
+		if(infos[i]->rank < 1){
+			printf("Unsupported dataset rank: %d\n", infos[i]->rank);
+			infos[i] = NULL;
+			continue;
+		}
+		total_rows += infos[i]->dims[0];
+	}
+	if(num_rows < 0){
+		first_row = 0;
+		num_rows = total_rows;
+	}
+	hsize_t win_lo = first_row;
+	hsize_t win_hi = (hsize_t)first_row + num_rows;
+	hsize_t total_size = 0;
+	hsize_t start = 0;
+	for(i = 0; i < num_datasets; i++){
+		if(infos[i] == NULL){
+			continue;
+		}
+		hsize_t end = start + infos[i]->dims[0];
+		hsize_t lo = win_lo > start ? win_lo : start;
+		hsize_t hi = win_hi < end ? win_hi : end;
+		if(lo < hi){
+			total_size += (hi - lo) * (infos[i]->num_points / infos[i]->dims[0]);
+		}
+		start = end;
+	}
+	*size = total_size;
+	if(total_size == 0){
+		return NULL;
+	}
+	af_real* data = malloc(total_size * sizeof(af_real));
+	if(data == NULL){
+		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
+		return NULL;
+	}
+
+	//Read pass - a hyperslab of whole rows per granule
+	hsize_t pos = 0;
+	start = 0;
+	for(i = 0; i < num_datasets; i++){
+		if(infos[i] == NULL){
+			continue;
+		}
+		int rank = infos[i]->rank;
+		hsize_t end = start + infos[i]->dims[0];
+		hsize_t lo = win_lo > start ? win_lo : start;
+		hsize_t hi = win_hi < end ? win_hi : end;
+		if(lo < hi){
+			hsize_t offset[rank];
+			hsize_t count[rank];
+			int d;
+			for(d = 0; d < rank; d++){
+				offset[d] = 0;
+				count[d] = infos[i]->dims[d];
+			}
+			offset[0] = lo - start;
+			count[0] = hi - lo;
+			if(af_read_hyperslab_into(file, dataset_names[i], rank, offset, count, NULL, &data[pos], AF_REAL_TYPE) < 0){
+				free(data);
+				*size = 0;
+				return NULL;
+			}
+			pos += (hi - lo) * (infos[i]->num_points / infos[i]->dims[0]);
+		}
+		start = end;
+	}
+	return data;
+}
+
+//Whole-swath writers of testReproHDF5; MODIS 1km rows are 1354 cells wide
+int af_write_misr_on_modis(hid_t output_file, af_real* misr_out, af_real* modis, int modis_bands, int modis_size, int misr_size){
+	hsize_t rows = misr_size / MODIS_1KM_COLS;
+	if((hsize_t)modis_size != modis_bands * rows * MODIS_1KM_COLS){
+		printf("MODIS size %d does not match %d bands of %llu rows\n", modis_size, modis_bands, (unsigned long long)rows);
+		return -1;
+	}
+	return af_write_misr_on_modis_rows(output_file, misr_out, modis, modis_bands, rows, MODIS_1KM_COLS, 0, rows);
+}
+
+int af_write_mm_geo(hid_t output_file, int geo_flag, af_real* geo_data, int geo_size){
+	hsize_t rows = geo_size / MODIS_1KM_COLS;
+	return af_write_mm_geo_rows(output_file, geo_flag, geo_data, rows, MODIS_1KM_COLS, 0, rows);
+}
+
+#ifdef AF_PARALLEL_IO
+//Output file shared by all ranks of comm through the MPI-IO driver. info carries the collective buffering
+//and file system hints; metadata reads and writes are collective so rank 0 is not a metadata bottleneck
+hid_t af_create_output_mpio(char* output_path, MPI_Comm comm, MPI_Info info){
+	hid_t fapl = H5Pcreate(H5P_FILE_ACCESS);
+	H5Pset_fapl_mpio(fapl, comm, info);
+	H5Pset_all_coll_metadata_ops(fapl, 1);
+	H5Pset_coll_metadata_write(fapl, 1);
+	hid_t output_file = H5Fcreate(output_path, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+	H5Pclose(fapl);
+	if(output_file < 0){
+		printf("Output file create error\n");
+	}
+	return output_file;
+}
+#endif
+
+//Transfer property list of a write: collective when the file is open through MPI-IO, default otherwise
+static hid_t af_write_plist(hid_t dataset){
+	hid_t dxpl = H5Pcreate(H5P_DATASET_XFER);
+#ifdef AF_PARALLEL_IO
+	hid_t file = H5Iget_file_id(dataset);
+	hid_t fapl = H5Fget_access_plist(file);
+	if(H5Pget_driver(fapl) == H5FD_MPIO){
+		H5Pset_dxpl_mpio(dxpl, H5FD_MPIO_COLLECTIVE);
+	}
+	H5Pclose(fapl);
+	H5Fclose(file);
+#else
+	(void)dataset;
+#endif
+	return dxpl;
+}
+
+//Default output layout: chunks of AF_CHUNK_ROWS scan lines (one band plane deep), shuffle + deflate 4 when available
+af_dataset_schema af_default_schema(char* d_name, hsize_t bands, hsize_t cols){
+	af_dataset_schema schema;
+	schema.d_name = d_name;
+	schema.bands = bands;
+	schema.cols = cols;
+	schema.chunk_rows = AF_CHUNK_ROWS;
+	schema.shuffle = 1;
+	schema.deflate_level = 4;
+	schema.filter = 0;
+	schema.filter_num_cd = 0;
+	schema.encoding = AF_ENC_REAL;
+	schema.scale_factor = AF_INT16_SCALE;
+	schema.add_offset = AF_INT16_OFFSET;
+	return schema;
+}
+
+static void af_write_attr(hid_t dataset, char* attr_name, hid_t type, void* value){
+	hid_t space = H5Screate(H5S_SCALAR);
+	hid_t attr = H5Acreate2(dataset, attr_name, type, space, H5P_DEFAULT, H5P_DEFAULT);
+	H5Awrite(attr, type, value);
+	H5Aclose(attr);
+	H5Sclose(space);
+}
+
+//Bytes per value of the buffer a write of the schema packs into, 0 when af_real is written as is
+size_t af_pack_size(af_dataset_schema* schema){
+	if(schema->encoding == AF_ENC_INT16){
+		return sizeof(short);
+	}
+	if(schema->encoding == AF_ENC_FLOAT32 && sizeof(af_real) != sizeof(float)){
+		return sizeof(float);
+	}
+	return 0;
+}
+
+//Pack kernels run right before the write, one pass over the slab
+static void af_pack_float32(af_real* data, float* packed, size_t n){
+	size_t i;
+	#pragma omp parallel for simd schedule(static)
+	for(i = 0; i < n; i++){
+		packed[i] = (float)data[i];
+	}
+}
+
+//Rounds half away from zero and saturates, so values out of range keep the nearest end instead of wrapping
+static void af_pack_int16(af_real* data, short* packed, size_t n, double scale_factor, double add_offset){
+	const af_real inv_scale = 1 / scale_factor;
+	const af_real offset = add_offset;
+	size_t i;
+	#pragma omp parallel for simd schedule(static)
+	for(i = 0; i < n; i++){
+		af_real q = (data[i] - offset) * inv_scale;
+		q += q < 0 ? -0.5f : 0.5f;
+		q = q > 32767 ? 32767 : q;
+		q = q < -32767 ? -32767 : q;
+		packed[i] = data[i] == -999 ? AF_INT16_FILL : (short)q;
+	}
+}
+
+//Creates a dataset of num_rows scan lines that can grow along the row axis, with its parent groups
+hid_t af_create_dataset(hid_t output_file, af_dataset_schema* schema, hsize_t num_rows){
+	int rank = schema->bands > 0 ? 3 : 2;
+	int row_axis = rank - 2;
+	hsize_t dims[3];
+	hsize_t max_dims[3];
+	hsize_t chunk[3];
+	if(rank == 3){
+		dims[0] = max_dims[0] = schema->bands;
+		chunk[0] = 1;
+	}
+	dims[row_axis] = num_rows;
+	max_dims[row_axis] = H5S_UNLIMITED;
+	chunk[row_axis] = schema->chunk_rows > 0 ? schema->chunk_rows : AF_CHUNK_ROWS;
+	dims[row_axis + 1] = max_dims[row_axis + 1] = schema->cols;
+	chunk[row_axis + 1] = schema->cols > 0 ? schema->cols : 1;
+	
+	hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+	H5Pset_chunk(dcpl, rank, chunk);
+	hid_t datatype;
+	if(schema->encoding == AF_ENC_INT16){
+		datatype = H5Tcopy(H5T_NATIVE_SHORT);
+		H5Pset_fill_value(dcpl, H5T_NATIVE_SHORT, &(short){AF_INT16_FILL});
+	}
+	else{
+		datatype = H5Tcopy(schema->encoding == AF_ENC_FLOAT32 ? H5T_NATIVE_FLOAT : af_mem_type_id(AF_REAL_TYPE));
+		H5Pset_fill_value(dcpl, af_mem_type_id(AF_REAL_TYPE), &(af_real){-999});
+	}
+	H5Tset_order(datatype, H5T_ORDER_LE);
+	//Filters are skipped, not fatal, when the library lacks them
+	if(schema->shuffle && H5Zfilter_avail(H5Z_FILTER_SHUFFLE) > 0){
+		H5Pset_shuffle(dcpl);
+	}
+	if(schema->deflate_level > 0 && H5Zfilter_avail(H5Z_FILTER_DEFLATE) > 0){
+		H5Pset_deflate(dcpl, schema->deflate_level);
+	}
+	if(schema->filter > 0){
+		if(H5Zfilter_avail(schema->filter) > 0){
+			H5Pset_filter(dcpl, schema->filter, H5Z_FLAG_OPTIONAL, schema->filter_num_cd, schema->filter_cd);
+		}
+		else{
+			printf("Filter %d not available, writing %s without it\n", (int)schema->filter, schema->d_name);
+		}
+	}
+	hid_t lcpl = H5Pcreate(H5P_LINK_CREATE);
+	H5Pset_create_intermediate_group(lcpl, 1);
+	
+	hid_t dataspace = H5Screate_simple(rank, dims, max_dims);
+	hid_t dataset = H5Dcreate2(output_file, schema->d_name, datatype, dataspace, lcpl, dcpl, H5P_DEFAULT);
+	H5Tclose(datatype);
+	H5Sclose(dataspace);
+	H5Pclose(lcpl);
+	H5Pclose(dcpl);
+	if(dataset < 0){
+		printf("Dataset create error: %s\n", schema->d_name);
+		return dataset;
+	}
+	//Packing attributes follow the CF convention, so readers unpack value = stored * scale_factor + add_offset
+	if(schema->encoding == AF_ENC_INT16){
+		af_write_attr(dataset, "scale_factor", H5T_NATIVE_DOUBLE, &schema->scale_factor);
+		af_write_attr(dataset, "add_offset", H5T_NATIVE_DOUBLE, &schema->add_offset);
+		af_write_attr(dataset, "_FillValue", H5T_NATIVE_SHORT, &(short){AF_INT16_FILL});
+	}
+	return dataset;
+}
+
+//Writes rows [first_row, first_row + num_rows) of a dataset made by af_create_dataset from schema; data is band
+//major for banded datasets. When the file is shared through MPI-IO every process calls this, with num_rows 0 if
+//it has none. Encoded datasets are packed into the caller's buffer packed, of af_pack_size(schema) bytes per value
+herr_t af_write_dataset_rows(hid_t dataset, af_dataset_schema* schema, af_real* data, hsize_t first_row, hsize_t num_rows, void* packed){
+	hid_t dataspace = H5Dget_space(dataset);
+	int rank = H5Sget_simple_extent_ndims(dataspace);
+	int row_axis = rank - 2;
+	hsize_t dims[3];
+	H5Sget_simple_extent_dims(dataspace, dims, NULL);
+	hsize_t offset[3] = {0, 0, 0};
+	hsize_t count[3];
+	int i;
+	for(i = 0; i < rank; i++){
+		count[i] = dims[i];
+	}
+	offset[row_axis] = first_row;
+	count[row_axis] = num_rows;
+	hid_t memspace = H5Screate_simple(rank, count, NULL);
+	if(num_rows > 0){
+		H5Sselect_hyperslab(dataspace, H5S_SELECT_SET, offset, NULL, count, NULL);
+	}
+	else{
+		H5Sselect_none(dataspace);
+		H5Sselect_none(memspace);
+	}
+	//Encoded datasets get the slab packed to their stored type; HDF5 then writes it without conversion.
+	//The encoding comes from the schema, so a write makes the same metadata calls on every process
+	size_t n = 1;
+	for(i = 0; i < rank; i++){
+		n *= count[i];
+	}
+	hid_t mem_type = af_mem_type_id(AF_REAL_TYPE);
+	void* buf = data;
+	size_t pack_size = af_pack_size(schema);
+	if(pack_size > 0){
+		buf = packed;
+		mem_type = schema->encoding == AF_ENC_INT16 ? H5T_NATIVE_SHORT : H5T_NATIVE_FLOAT;
+	}
+	herr_t status = 0;
+	if(n > 0 && pack_size > 0 && packed == NULL){
+		printf("No packing buffer for %s\n", schema->d_name);
+		status = -1;
+	}
+	else if(n > 0 && schema->encoding == AF_ENC_INT16){
+		af_pack_int16(data, packed, n, schema->scale_factor, schema->add_offset);
+	}
+	else if(n > 0 && pack_size > 0){
+		af_pack_float32(data, packed, n);
+	}
+	hid_t dxpl = af_write_plist(dataset);
+	//A process that failed to pack still takes part in the collective write, with nothing selected
+	if(status < 0){
+		H5Sselect_none(dataspace);
+		H5Sselect_none(memspace);
+		H5Dwrite(dataset, mem_type, memspace, dataspace, dxpl, buf);
+	}
+	else{
+		status = H5Dwrite(dataset, mem_type, memspace, dataspace, dxpl, buf);
+	}
+	H5Pclose(dxpl);
+	H5Sclose(memspace);
+	H5Sclose(dataspace);
+	if(status < 0){
+		printf("write error: %d\n", status);
+	}
+	return status;
+}
+
+//Grows the dataset by num_rows scan lines and writes them, so a granule can be written as soon as it is done
+herr_t af_append_rows(hid_t dataset, af_dataset_schema* schema, af_real* data, hsize_t num_rows, void* packed){
+	hid_t dataspace = H5Dget_space(dataset);
+	int rank = H5Sget_simple_extent_ndims(dataspace);
+	hsize_t dims[3];
+	H5Sget_simple_extent_dims(dataspace, dims, NULL);
+	H5Sclose(dataspace);
+	hsize_t first_row = dims[rank - 2];
+	dims[rank - 2] += num_rows;
+	if(H5Dset_extent(dataset, dims) < 0){
+		printf("Dataset extend error\n");
+		return -1;
+	}
+	return af_write_dataset_rows(dataset, schema, data, first_row, num_rows, packed);
+}
+
+static int af_write_schema_rows(hid_t output_file, af_dataset_schema schema, af_real* data, hsize_t total_rows, hsize_t first_row, hsize_t num_rows){
+	hid_t dataset = af_create_dataset(output_file, &schema, total_rows);
+	if(dataset < 0){
+		return -1;
+	}
+	void* packed = NULL;
+	size_t n = num_rows * schema.cols * (schema.bands > 0 ? schema.bands : 1);
+	if(af_pack_size(&schema) > 0 && n > 0 && NULL == (packed = malloc(af_pack_size(&schema) * n))){
+		printf("Out of memory packing %s\n", schema.d_name);
+	}
+	herr_t status = af_write_dataset_rows(dataset, &schema, data, first_row, num_rows, packed);
+	free(packed);
+	H5Dclose(dataset);
+	return status < 0 ? -1 : 1;
+}
+
+//Row slab versions of af_write_mm_geo and af_write_misr_on_modis: the datasets cover total_rows x cols
+//and this process writes rows [first_row, first_row + num_rows). modis is band major, [band][num_rows x cols]
+int af_write_mm_geo_rows(hid_t output_file, int geo_flag, af_real* geo_data, hsize_t total_rows, hsize_t cols, hsize_t first_row, hsize_t num_rows){
+	char* d_name = geo_flag == 0 ? "/Geolocation/Latitude" : "/Geolocation/Longitude";
+	if(af_write_schema_rows(output_file, af_default_schema(d_name, 0, cols), geo_data, total_rows, first_row, num_rows) < 0){
+		printf("Geo Data write error\n");
+		return -1;
+	}
+	return 1;
+}
+
+int af_write_misr_on_modis_rows(hid_t output_file, af_real* misr_out, af_real* modis, int modis_bands, hsize_t total_rows, hsize_t cols, hsize_t first_row, hsize_t num_rows){
+	if(af_write_schema_rows(output_file, af_default_schema("/Data_Fields/modis_rad", modis_bands, cols), modis, total_rows, first_row, num_rows) < 0){
+		printf("MODIS write error\n");
+		return -1;
+	}
+	if(af_write_schema_rows(output_file, af_default_schema("/Data_Fields/misr_out", 0, cols), misr_out, total_rows, first_row, num_rows) < 0){
+		printf("MISR write error\n");
+		return -1;
+	}
+	return 1;
+}
+
+//Nearest neighbor mapping cache - one sidecar HDF5 file, one dataset per mapping key
+//IDs are stored delta encoded (neighbouring targets map to neighbouring sources) with shuffle + deflate
+int* af_read_nn_mapping(char* cache_path, unsigned long long key, int n_tar){
+	FILE* f = fopen(cache_path, "r");
+	if(f == NULL){
+		return NULL;
+	}
+	fclose(f);
+	hid_t cache = H5Fopen(cache_path, H5F_ACC_RDONLY, H5P_DEFAULT);
+	if(cache < 0){
+		return NULL;
+	}
+	char d_name[AF_PATH_LEN];
+	snprintf(d_name, AF_PATH_LEN, "/NNMapping/%016llx", key);
+	if(H5Lexists(cache, "/NNMapping", H5P_DEFAULT) <= 0 || H5Lexists(cache, d_name, H5P_DEFAULT) <= 0){
+		H5Fclose(cache);
+		return NULL;
+	}
+	//A sidecar left half written by an interrupted run is a cache miss
+	hid_t dataset = H5Dopen2(cache, d_name, H5P_DEFAULT);
+	if(dataset < 0){
+		H5Fclose(cache);
+		return NULL;
+	}
+	hid_t dataspace = H5Dget_space(dataset);
+	if(H5Sget_simple_extent_npoints(dataspace) != n_tar){
+		printf("Cached mapping size does not match target size\n");
+		H5Sclose(dataspace);
+		H5Dclose(dataset);
+		H5Fclose(cache);
+		return NULL;
+	}
+	int* ids = malloc(sizeof(int) * (n_tar > 0 ? n_tar : 1));
+	if(ids == NULL){
+		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
+		H5Sclose(dataspace);
+		H5Dclose(dataset);
+		H5Fclose(cache);
+		return NULL;
+	}
+	herr_t status = H5Dread(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, ids);
+	H5Sclose(dataspace);
+	H5Dclose(dataset);
+	H5Fclose(cache);
+	if(status < 0){
+		printf("read error: %d\n", status);
+		free(ids);
+		return NULL;
+	}
+	int i;
+	for(i = 1; i < n_tar; i++){
+		ids[i] += ids[i - 1];
+	}
+	return ids;
+}
+
+int af_write_nn_mapping(char* cache_path, unsigned long long key, int* tar_nn_sou_id, int n_tar){
+	hid_t cache = -1;
+	FILE* f = fopen(cache_path, "r");
+	if(f != NULL){
+		fclose(f);
+		cache = H5Fopen(cache_path, H5F_ACC_RDWR, H5P_DEFAULT);
+	}
+	else{
+		cache = H5Fcreate(cache_path, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+	}
+	if(cache < 0){
+		printf("Mapping cache open error\n");
+		return -1;
+	}
+	if(H5Lexists(cache, "/NNMapping", H5P_DEFAULT) <= 0){
+		hid_t group = H5Gcreate2(cache, "/NNMapping", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+		H5Gclose(group);
+	}
+	char d_name[AF_PATH_LEN];
+	snprintf(d_name, AF_PATH_LEN, "/NNMapping/%016llx", key);
+	if(H5Lexists(cache, d_name, H5P_DEFAULT) > 0){
+		H5Fclose(cache);
+		return 1;
+	}
+	
+	int* deltas = malloc(sizeof(int) * (n_tar > 0 ? n_tar : 1));
+	int i;
+	for(i = n_tar - 1; i > 0; i--){
+		deltas[i] = tar_nn_sou_id[i] - tar_nn_sou_id[i - 1];
+	}
+	if(n_tar > 0){
+		deltas[0] = tar_nn_sou_id[0];
+	}
+	
+	hsize_t dim[1] = {n_tar};
+	hid_t dataspace = H5Screate_simple(1, dim, NULL);
+	hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+	if(n_tar > 0 && H5Zfilter_avail(H5Z_FILTER_DEFLATE) > 0){
+		hsize_t chunk[1] = {n_tar < 65536 ? n_tar : 65536};
+		H5Pset_chunk(dcpl, 1, chunk);
+		H5Pset_shuffle(dcpl);
+		H5Pset_deflate(dcpl, 4);
+	}
+	hid_t dataset = H5Dcreate2(cache, d_name, H5T_STD_I32LE, dataspace, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+	herr_t status = H5Dwrite(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, deltas);
+	H5Dclose(dataset);
+	H5Pclose(dcpl);
+	H5Sclose(dataspace);
+	H5Fclose(cache);
+	free(deltas);
+	if(status < 0){
+		printf("Mapping write error\n");
+		return -1;
+	}
+	return 1;
+}
+
+hid_t af_open(char* file_path){
+	hid_t f = H5Fopen(file_path, H5F_ACC_RDONLY, H5P_DEFAULT);
+	if(f >= 0){
+		af_get_catalog(f);
+	}
+	return f;
+}
+
+herr_t af_close(hid_t file){
+	af_free_catalog(file);
+	herr_t ret = H5Fclose(file);
+	return ret;
+}
+
+//File catalogs - one per open file, built by a single H5Ovisit traversal
+static af_catalog* catalogs = NULL;
+
+#if H5_VERSION_GE(1,12,0)
+typedef H5O_info2_t af_obj_info_t;
+#else
+typedef H5O_info_t af_obj_info_t;
+#endif
+
+static herr_t af_catalog_visit(hid_t obj, const char* name, const af_obj_info_t* info, void* op_data){
+	af_catalog* catalog = (af_catalog*)op_data;
+	if(strcmp(name, ".") == 0){
+		return 0;
+	}
+	const char* sep = strchr(name, '/');
+	if(info->type == H5O_TYPE_GROUP){
+		if(sep == NULL){
+			//Top level group - an instrument
+			catalog->instruments = realloc(catalog->instruments, (catalog->num_instruments + 1) * sizeof(af_instrument_info));
+			af_instrument_info* inst = &catalog->instruments[catalog->num_instruments];
+			inst->name = strdup(name);
+			inst->granules = NULL;
+			inst->num_granules = 0;
+			catalog->num_instruments += 1;
+		}
+		else if(strchr(sep + 1, '/') == NULL){
+			//Second level group - a granule of its instrument
+			int i;
+			for(i = 0; i < catalog->num_instruments; i++){
+				af_instrument_info* inst = &catalog->instruments[i];
+				if(strlen(inst->name) == (size_t)(sep - name) && strncmp(name, inst->name, sep - name) == 0){
+					inst->granules = realloc(inst->granules, (inst->num_granules + 1) * sizeof(char*));
+					inst->granules[inst->num_granules] = strdup(sep + 1);
+					inst->num_granules += 1;
+					break;
+				}
+			}
+		}
+	}
+	else if(info->type == H5O_TYPE_DATASET){
+		hid_t dataset = H5Dopen2(obj, name, H5P_DEFAULT);
+		if(dataset < 0){
+			return 0;
+		}
+		if(catalog->num_datasets == catalog->capacity){
+			catalog->capacity = (catalog->capacity == 0) ? 256 : catalog->capacity * 2;
+			catalog->datasets = realloc(catalog->datasets, catalog->capacity * sizeof(af_dataset_info));
+		}
+		af_dataset_info* d = &catalog->datasets[catalog->num_datasets];
+		d->path = malloc(strlen(name) + 2);
+		d->path[0] = '/';
+		strcpy(&d->path[1], name);
+		
+		hid_t dataspace = H5Dget_space(dataset);
+		d->rank = H5Sget_simple_extent_ndims(dataspace);
+		d->dims = malloc(sizeof(hsize_t) * (d->rank > 0 ? d->rank : 1));
+		H5Sget_simple_extent_dims(dataspace, d->dims, NULL);
+		d->num_points = H5Sget_simple_extent_npoints(dataspace);
+		H5Sclose(dataspace);
+		
+		hid_t dtype = H5Dget_type(dataset);
+		d->type_class = H5Tget_class(dtype);
+		d->type_size = H5Tget_size(dtype);
+		H5Tclose(dtype);
+		
+		hid_t dcpl = H5Dget_create_plist(dataset);
+		d->layout = H5Pget_layout(dcpl);
+		d->chunk_dims = NULL;
+		if(d->layout == H5D_CHUNKED){
+			d->chunk_dims = malloc(sizeof(hsize_t) * d->rank);
+			H5Pget_chunk(dcpl, d->rank, d->chunk_dims);
+		}
+		H5Pclose(dcpl);
+		d->storage_size = H5Dget_storage_size(dataset);
+		H5Dclose(dataset);
+		catalog->num_datasets += 1;
+	}
+	return 0;
+}
+
+static int af_compare_dataset_path(const void* a, const void* b){
+	return strcmp(((const af_dataset_info*)a)->path, ((const af_dataset_info*)b)->path);
+}
+
+//Returns the catalog of an open file, building it on first use
+af_catalog* af_get_catalog(hid_t file){
+	af_catalog* catalog;
+	for(catalog = catalogs; catalog != NULL; catalog = catalog->next){
+		if(catalog->file == file){
+			return catalog;
+		}
+	}
+	catalog = calloc(1, sizeof(af_catalog));
+	catalog->file = file;
+#if H5_VERSION_GE(1,12,0)
+	herr_t status = H5Ovisit3(file, H5_INDEX_NAME, H5_ITER_INC, af_catalog_visit, catalog, H5O_INFO_BASIC);
+#else
+	herr_t status = H5Ovisit2(file, H5_INDEX_NAME, H5_ITER_INC, af_catalog_visit, catalog, H5O_INFO_BASIC);
+#endif
+	if(status < 0){
+		printf("Catalog traversal error\n");
+	}
+	qsort(catalog->datasets, catalog->num_datasets, sizeof(af_dataset_info), af_compare_dataset_path);
+	catalog->next = catalogs;
+	catalogs = catalog;
+	return catalog;
+}
+
+void af_free_catalog(hid_t file){
+	af_catalog** link = &catalogs;
+	while(*link != NULL && (*link)->file != file){
+		link = &(*link)->next;
+	}
+	af_catalog* catalog = *link;
+	if(catalog == NULL){
+		return;
+	}
+	*link = catalog->next;
+	int i, j;
+	for(i = 0; i < catalog->num_datasets; i++){
+		free(catalog->datasets[i].path);
+		free(catalog->datasets[i].dims);
+		free(catalog->datasets[i].chunk_dims);
+	}
+	free(catalog->datasets);
+	for(i = 0; i < catalog->num_instruments; i++){
+		for(j = 0; j < catalog->instruments[i].num_granules; j++){
+			free(catalog->instruments[i].granules[j]);
+		}
+		free(catalog->instruments[i].granules);
+		free(catalog->instruments[i].name);
+	}
+	free(catalog->instruments);
+	free(catalog);
+}
+
+//Dataset lookup by absolute path, NULL when the dataset does not exist
+af_dataset_info* af_catalog_lookup(hid_t file, char* dataset_name){
+	af_catalog* catalog = af_get_catalog(file);
+	af_dataset_info key;
+	key.path = dataset_name;
+	return bsearch(&key, catalog->datasets, catalog->num_datasets, sizeof(af_dataset_info), af_compare_dataset_path);
+}
+
+//Granule group names of an instrument in name order, NULL when the instrument is not in the file
+char** af_catalog_granules(hid_t file, char* instrument, int* num_granules){
+	af_catalog* catalog = af_get_catalog(file);
+	int i;
+	for(i = 0; i < catalog->num_instruments; i++){
+		if(strcmp(catalog->instruments[i].name, instrument) == 0){
+			*num_granules = catalog->instruments[i].num_granules;
+			return catalog->instruments[i].granules;
+		}
+	}
+	*num_granules = 0;
+	return NULL;
+}
+
+/*int main (int argc, char *argv[]){
+	//Preset filename here for easy testing 
+	char* file_path = "/projects/TDataFus/kent/temp/40-orbit-file/Jun15.2/TERRA_BF_L1B_O69365_F000_V000.h5";
+	hid_t file;
+	argv[1] = file_path;
+	if(argc < 3){
+		printf("Usage: %s filename instrument_name extra_arguments\n", argv[0]);
+		return 0;
+	}
+	else if(strcmp(argv[2], "MISR") == 0){
+		if(argc < 6){
+			printf("MISR Usage: %s filename MISR camera_angle resolution(H/L) radiance\n", argv[0]);
+			return 0; 
+		}
+		else{
+			//MISR input requirements fulfilled 
+			//Open file
+			file = af_open(file_path);
+			if(file < 0){
+				printf("File not found\n");
+				return -1;
+			}
+						
+			int d_size = 0;
+			int* data_pt = &d_size;
+			af_real* data = get_misr_rad(file, argv[3], argv[4], argv[5], data_pt);
+			printf("Data size: %d\n", *data_pt);
+			
+			int lat_size = 0;
+			int* lat_pt = &lat_size;
+			af_real* lat_data = get_misr_lat(file, argv[4], lat_pt);
+			printf("Lat size: %d\n", *lat_pt);
+			
+			int long_size = 0;
+			int* long_pt = &long_size;
+			af_real* long_data = get_misr_long(file, argv[4], long_pt);
+			printf("Long size: %d\n", *long_pt);
+			
+			if(data != NULL && lat_data != NULL, long_data != NULL){
+				printf("MISR Data retrieval successful\n");
+			}
+			else{
+				printf("MISR Data retrieval failed\n");
+			}
+			
+			printf("Retrieving MISR attributes\n");
+			void* unit_attr;
+			unit_attr = get_misr_attr(file, argv[3], argv[4], argv[5], "Units", 0, unit_attr);
+			printf("Unit attr: %s\n", (char*)unit_attr);
+			void* fill_attr;
+			fill_attr = get_misr_attr(file, argv[3], argv[4], argv[5], "_FillValue", 0, fill_attr);
+			printf("FillValue: %f\n", *(float*) fill_attr);
+			void* lat_attr;
+			lat_attr = get_misr_attr(file, argv[3], argv[4], argv[5], "units", 1, lat_attr);
+			printf("lat_units: %s\n", (char*)lat_attr);
+			void* long_attr;
+			long_attr = get_misr_attr(file, argv[3], argv[4], argv[5], "units", 2, long_attr);
+			printf("long_units: %s\n", (char*)long_attr);
+			
+			herr_t ret = af_close(file);
+		}
+	}
+	else if(strcmp(argv[2], "MODIS") == 0){
+		if(argc < 4){
+			printf("MODIS Usage: %s filename MODIS resolution(1KM/500m/250m)\n", argv[0]);
+		}
+		else{
+			file = af_open(file_path);
+			if(file < 0){
+				printf("File not found\n");
+				return -1;
+			}
+			char* resolution = argv[3];
+			char* d_name = "";
+			if(strcmp(resolution, "1KM") == 0){
+				resolution = "_1KM";
+				d_name = "EV_1KM_RefSB";
+			}
+			else if(strcmp(resolution, "250M") == 0){
+				resolution = "_250m";
+				d_name = "EV_250_RefSB";
+			}
+			else if(strcmp(resolution, "500M") == 0){
+				resolution = "_500m";
+				d_name = "EV_500_RefSB";
+			}
+			else{
+				printf("Wrong resolution, choose from 1KM, 500M or 250M\n");
+			}
+			
+			int data_size = 0;
+			int* data_pt = &data_size;
+			af_real* data = get_modis_rad(file, resolution, d_name, data_pt);
+			printf("Data size: %d\n", *data_pt);
+			
+			int lat_size = 0;
+			int* lat_pt = &lat_size;
+			af_real* lat_data = get_modis_lat(file, resolution, d_name, lat_pt);
+			printf("Lat size: %d\n", *lat_pt);
+			
+			int long_size = 0;
+			int* long_pt = &long_size;
+			af_real* long_data = get_modis_long(file, resolution, d_name, long_pt);
+			printf("Long size: %d\n", *long_pt);
+
+			
+			if(data != NULL && lat_data != NULL, long_data != NULL){
+				printf("MODIS retrieval successful\n");
+			}
+			else{
+				printf("MODIS retrieval failed\n");
+			}
+			
+		
+			printf("Retrieving MODIS attributes\n");
+			void* unit_attr;
+			unit_attr = get_modis_attr(file, resolution, d_name, "units", 0, unit_attr);
+			void* fill_attr;
+			fill_attr = get_modis_attr(file, resolution, d_name, "_FillValue", 0, fill_attr);
+			void* min_attr;
+			min_attr = get_modis_attr(file, resolution, d_name, "valid_min", 0, min_attr);
+			void* lat_attr;
+			lat_attr = get_modis_attr(file, resolution, d_name, "units", 1, lat_attr);
+			void* long_attr;
+			long_attr = get_modis_attr(file, resolution, d_name, "units", 2, long_attr);
+			printf("Unit attr: %s\n", (char*)unit_attr);
+			printf("FillValue: %f\n", *(float*) fill_attr);
+			printf("valid_min: %f\n", *(float*) min_attr);
+			printf("lat unit: %s\n", (char*) lat_attr);
+			printf("long unit: %s\n", (char*) long_attr); 
+			
+			herr_t ret = af_close(file);
+		}
+	}
+	else if(strcmp(argv[2], "CERES") == 0){
+		if(argc < 6){
+			printf("CERES Usage: %s filename CERES camera radiance(LW/SW/WN/TOT) filtered/unfiltered(F/U)");
+		}
+		else{
+				file = af_open(file_path);
+				if(file < 0){
+					printf("File not found\n");
+					return -1;
+				}
+				char* d_name = calloc(30, sizeof(char));
+				if(strcmp(argv[5], "F") == 0){
+					char* f = "_Filtered";
+					char* r = "_Radiance";
+					strcpy(d_name, argv[4]);
+					strncat(d_name, f, strlen(f));
+					strncat(d_name, r, strlen(r));
+				}
+				else{
+					char* r = "_Radiance";
+					strcpy(d_name, argv[4]);
+					strncat(d_name, r, strlen(r));
+				}
+				
+				int data_size = 0;
+				int* data_pt = &data_size;
+				af_real* data = get_ceres_rad(file, argv[3], d_name, data_pt);
+				printf("Data size: %d\n", *data_pt);
+				
+				int lat_size = 0;
+				int* lat_pt = &lat_size;
+				af_real* lat_data = get_ceres_lat(file, argv[3], d_name, lat_pt);
+				printf("Lat size: %d\n", *lat_pt);
+
+				int long_size = 0;
+				int* long_pt = &long_size;
+				af_real* long_data = get_ceres_long(file, argv[3], d_name, long_pt);
+				printf("Long size: %d\n", *long_pt);
+				
+				herr_t ret = af_close(file);
+		}
+	}
+	else if(strcmp(argv[2], "MOPITT") == 0){
+		file = af_open(file_path);
+		if(file < 0){
+			printf("File not found\n");
+			return -1;
+		}
+		int data_size = 0;
+		int* data_pt = &data_size;
+		af_real* data = get_mop_rad(file, data_pt);
+		printf("Data size: %d\n", *data_pt);
+		
+		int lat_size = 0;
+		int* lat_pt = &lat_size;
+		af_real* lat_data = get_mop_lat(file, lat_pt);
+		printf("Lat size: %d\n", *lat_pt);
+
+		int long_size = 0;
+		int* long_pt = &long_size;
+		af_real* long_data = get_mop_long(file, long_pt);
+		printf("Long size: %d\n", *long_pt);
+		
+		herr_t ret = af_close(file);
+	}
+	else if(strcmp(argv[2], "ASTER") == 0){
+		if(argc < 5){
+			printf("ASTER Usage: %s filename ASTER subsystem(TIR/VNIR/SWIR) dataset_name\n");
+		}
+		else{
+				file = af_open(file_path);
+				if(file < 0){
+					printf("File not found\n");
+					return -1;
+				}
+				
+				int data_size = 0;
+				int* data_pt = &data_size;
+				af_real* data = get_ast_rad(file, argv[3], argv[4], data_pt);
+				if(data != NULL){
+					printf("Data size: %d\n", *data_pt);	
+				}
+				int lat_size = 0;
+				int* lat_pt = &lat_size;
+				af_real* lat_data = get_ast_lat(file, argv[3], argv[4], lat_pt);
+				printf("Lat size: %d\n", *lat_pt);
+				
+				int long_size = 0;
+				int* long_pt = &long_size;
+				printf("going into ast_long\n");
+				af_real* long_data = get_ast_long(file, argv[3], argv[4], long_pt);
+				printf("Long size: %d\n", *long_pt);	
+				
+				herr_t ret = af_close(file);	
+		}
+	}
+	else{
+		printf("Invalid instrument\n");
+	}
+	
+	return 0;
+}*/
+
+//Helper Functions
+//String helper
+void concat_by_sep(char** source, const char** w, char* sep, size_t length, int arr_size){
+	int i;
+	*source = calloc(length+20, sizeof(char));
+	for(i = 0; i < arr_size; i++){
+		if(i == 0){
+			strncpy(*source, sep, strlen(sep));
+			strncat(*source, w[i], strlen(w[i]));
+		}
+		else{
+			strncat(*source, sep, strlen(sep));
+			strncat(*source, w[i], strlen(w[i]));
+		}
+	}
+}
+//Summing up dimensions
+double dim_sum(hsize_t* dims, int arr_len){
+	double sum = 0.0;
+	int i;
+	for(i = 0; i < arr_len; i++){
+		if(i == 0){
+			sum = (double)dims[i];
+		}
+		else{
+			sum *= (double)dims[i];
+		}
+	}
+	return sum;
+}
+//Memory type used by the typed reads
+hid_t af_mem_type_id(af_mem_type mem_type){
+	if(mem_type == AF_FLOAT32){
+		return H5T_NATIVE_FLOAT;
+	}
+	return H5T_NATIVE_DOUBLE;
+}
+//Only numeric datasets can be converted to floating point during H5Dread
+int af_check_type_class(hid_t dataset){
+	hid_t dtype = H5Dget_type(dataset);
+	H5T_class_t type_class = H5Tget_class(dtype);
+	H5Tclose(dtype);
+	if(type_class != H5T_FLOAT && type_class != H5T_INTEGER){
+		printf("Unsupported datatype class: %d\n", type_class);
+		return -1;
+	}
+	return 0;
+}
+//Turning float to double
+double float_to_double(float f){
+	char buf[50];
+	sprintf(buf, "%.7g", f);
+	return atof(buf);
+}
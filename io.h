@@ -1,53 +1,169 @@
-/*
-
-
-    AUTHOR:
-        Yat Long Lo
-
-    EMAIL:
-        yllo2@illinois.edu
-
-
-*/
-#include <hdf5.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <strings.h>
-#include <string.h>
-#define FALSE   0
-
-//HDF5 API operations wrapper
-hid_t af_open(char* file_path);
-herr_t af_close(hid_t file);
-double* af_read(hid_t file, char* dataset_name);
-double* af_read_hyperslab(hid_t file, char*dataset_name, int x_offset, int y_offset, int z_offset);
-hsize_t* af_read_size(hid_t file, char* dataset_name);
-int af_write_misr_on_modis(hid_t output_file, double* misr_out, double* modis, int modis_size, int misr_size);
-int af_write_mm_geo(hid_t output_file, int geo_flag, double* geo_data, int geo_size);
-
-//Instrument data retrieval functions
-double* get_misr_rad(hid_t file, char* camera_angle, char* resolution, char* radiance, int* size);
-double* get_misr_lat(hid_t file, char* resolution, int* size);
-double* get_misr_long(hid_t file, char* resolution, int* size);
-void* get_misr_attr(hid_t file, char* camera_angle, char* resolution, char* radiance, char* attr_name, int geo, void* attr_pt);
-double* get_modis_rad(hid_t file, char* resolution, char* bands[], int band_size, int* size);
-double* get_modis_rad_by_band(hid_t file, char* resolution, char* d_name, int* band_index, int* size);
-double* get_modis_lat(hid_t file, char* resolution, char* d_name, int* size);
-double* get_modis_long(hid_t file, char* resolution, char* d_name, int* size);
-double* get_modis_attr(hid_t file, char* resolution, char* d_name, char* attr_name, int geo, void* attr_pt);
-char* get_modis_filename(char* resolution, char* band, int* band_index);
-double* get_ceres_rad(hid_t file, char* camera, char* d_name, int* size);
-double* get_ceres_lat(hid_t file, char* camera, char* d_name, int* size);
-double* get_ceres_long(hid_t file, char* camera, char* d_name, int* size);
-double* get_mop_rad(hid_t file, int* size);
-double* get_mop_lat(hid_t file, int*size);
-double* get_mop_long(hid_t file, int* size);
-double* get_ast_rad(hid_t file, char* subsystem, char* d_name, int*size);
-double* get_ast_lat(hid_t file, char* subsystem, char* d_name, int*size);
-double* get_ast_long(hid_t file, char* subsystem, char* d_name, int*size);
-
-//Helper functions
-void concat_by_sep(char** source, const char** w, char* sep, size_t length, int arr_size);
-double dim_sum(hsize_t* dims, int arr_len);
-double float_to_double(float f);
-double misr_averaging(double window[16]);
+/*
+
+
+    AUTHOR:
+        Yat Long Lo
+
+    EMAIL:
+        yllo2@illinois.edu
+
+
+*/
+#include <hdf5.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <string.h>
+#include "reproject.h"
+#define FALSE   0
+
+//Memory types for typed reads
+typedef enum {AF_FLOAT32, AF_FLOAT64} af_mem_type;
+//Memory type matching af_real (float32 when built with -DAF_USE_FLOAT32)
+#ifdef AF_USE_FLOAT32
+#define AF_REAL_TYPE AF_FLOAT32
+#else
+#define AF_REAL_TYPE AF_FLOAT64
+#endif
+
+//Maximum length of a dataset path
+#define AF_PATH_LEN 256
+
+//Width of a MODIS 1km swath
+#define MODIS_1KM_COLS 1354
+//Scan lines per output chunk (one MODIS 1km scan)
+#define AF_CHUNK_ROWS 10
+
+//Encodings of output datasets: af_real as is, float32, or 16 bit integers packed as
+//(value - add_offset) / scale_factor with AF_INT16_FILL standing for -999
+typedef enum {AF_ENC_REAL, AF_ENC_FLOAT32, AF_ENC_INT16} af_encoding;
+#define AF_INT16_FILL -32768
+//Default packing of radiance into int16: 0.01 steps over [0, 655.34]
+#define AF_INT16_SCALE 0.01
+#define AF_INT16_OFFSET 327.67
+
+//Layout of one output dataset: scan lines along the row axis, which can grow, chunked a few scan lines at a time
+typedef struct {
+	char* d_name;
+	hsize_t bands;			//0 for rows x cols, number of bands for bands x rows x cols
+	hsize_t cols;
+	hsize_t chunk_rows;
+	int shuffle;
+	int deflate_level;		//0 for no deflate
+	H5Z_filter_t filter;		//any other registered filter, 0 for none
+	size_t filter_num_cd;
+	unsigned int filter_cd[4];
+	af_encoding encoding;
+	double scale_factor;		//int16 encoding only
+	double add_offset;
+} af_dataset_schema;
+
+//Shared output through MPI-IO needs an MPI build (make MPI=1) linked against a parallel HDF5
+#if defined(AF_USE_MPI) && defined(H5_HAVE_PARALLEL)
+#define AF_PARALLEL_IO
+#include <mpi.h>
+#endif
+
+//Per-file catalog of instruments, granules and datasets, built once when the file is opened
+typedef struct {
+	char* path;
+	int rank;
+	hsize_t* dims;
+	hssize_t num_points;
+	H5T_class_t type_class;
+	size_t type_size;
+	H5D_layout_t layout;
+	hsize_t* chunk_dims;
+	hsize_t storage_size;
+} af_dataset_info;
+
+typedef struct {
+	char* name;
+	char** granules;
+	int num_granules;
+} af_instrument_info;
+
+typedef struct af_catalog {
+	hid_t file;
+	af_instrument_info* instruments;
+	int num_instruments;
+	af_dataset_info* datasets;
+	int num_datasets;
+	int capacity;
+	struct af_catalog* next;
+} af_catalog;
+
+//HDF5 API operations wrapper
+hid_t af_open(char* file_path);
+herr_t af_close(hid_t file);
+af_catalog* af_get_catalog(hid_t file);
+void af_free_catalog(hid_t file);
+af_dataset_info* af_catalog_lookup(hid_t file, char* dataset_name);
+char** af_catalog_granules(hid_t file, char* instrument, int* num_granules);
+af_real* af_read(hid_t file, char* dataset_name);
+herr_t af_read_into(hid_t file, char* dataset_name, void* dest, af_mem_type mem_type);
+af_real* af_read_hyperslab(hid_t file, char* dataset_name, int rank, hsize_t* offset, hsize_t* count, hsize_t* stride);
+herr_t af_read_hyperslab_into(hid_t file, char* dataset_name, int rank, hsize_t* offset, hsize_t* count, hsize_t* stride, void* dest, af_mem_type mem_type);
+af_real* af_read_block_average(hid_t file, char* dataset_name, int factor, int* size);
+af_real* af_read_block_average_range(hid_t file, char* dataset_name, int factor, hsize_t first_plane, hsize_t num_planes, int* size);
+af_real* af_read_slab(hid_t file, char* dataset_name, int axis, hsize_t start, hsize_t length, int* size);
+af_real* af_read_concat(hid_t file, char** dataset_names, int num_datasets, int* size);
+af_real* af_read_concat_rows(hid_t file, char** dataset_names, int num_datasets, int first_row, int num_rows, int* size);
+hsize_t* af_read_size(hid_t file, char* dataset_name);
+int af_write_misr_on_modis(hid_t output_file, af_real* misr_out, af_real* modis, int modis_bands, int modis_size, int misr_size);
+int af_write_mm_geo(hid_t output_file, int geo_flag, af_real* geo_data, int geo_size);
+af_dataset_schema af_default_schema(char* d_name, hsize_t bands, hsize_t cols);
+hid_t af_create_dataset(hid_t output_file, af_dataset_schema* schema, hsize_t num_rows);
+size_t af_pack_size(af_dataset_schema* schema);
+herr_t af_write_dataset_rows(hid_t dataset, af_dataset_schema* schema, af_real* data, hsize_t first_row, hsize_t num_rows, void* packed);
+herr_t af_append_rows(hid_t dataset, af_dataset_schema* schema, af_real* data, hsize_t num_rows, void* packed);
+int af_write_mm_geo_rows(hid_t output_file, int geo_flag, af_real* geo_data, hsize_t total_rows, hsize_t cols, hsize_t first_row, hsize_t num_rows);
+int af_write_misr_on_modis_rows(hid_t output_file, af_real* misr_out, af_real* modis, int modis_bands, hsize_t total_rows, hsize_t cols, hsize_t first_row, hsize_t num_rows);
+#ifdef AF_PARALLEL_IO
+hid_t af_create_output_mpio(char* output_path, MPI_Comm comm, MPI_Info info);
+#endif
+int* af_read_nn_mapping(char* cache_path, unsigned long long key, int n_tar);
+int af_write_nn_mapping(char* cache_path, unsigned long long key, int* tar_nn_sou_id, int n_tar);
+
+//Instrument data retrieval functions
+af_real* get_misr_rad(hid_t file, char* camera_angle, char* resolution, char* radiance, int* size);
+af_real* get_misr_rad_blocks(hid_t file, char* camera_angle, char* resolution, char* radiance, int first_block, int num_blocks, int* size);
+af_real* get_misr_lat(hid_t file, char* resolution, int* size);
+af_real* get_misr_long(hid_t file, char* resolution, int* size);
+void* get_misr_attr(hid_t file, char* camera_angle, char* resolution, char* radiance, char* attr_name, int geo, void* attr_pt);
+af_real* get_modis_rad(hid_t file, char* resolution, char* bands[], int band_size, int* size);
+af_real* get_modis_rad_by_band(hid_t file, char* resolution, char* d_name, int* band_index, int* size);
+af_real* get_modis_lat(hid_t file, char* resolution, char* d_name, int* size);
+af_real* get_modis_long(hid_t file, char* resolution, char* d_name, int* size);
+af_real* modis_read_geo(hid_t file, char* resolution, char* d_name, char* geo_name, char** names, int num_groups, int* size);
+hsize_t modis_swath_rows(hid_t file, char* resolution, char* d_name, char** names, int num_groups, hsize_t* granule_rows);
+af_real* modis_read_geo_rows(hid_t file, char* resolution, char* d_name, char* geo_name, char** names, int num_groups, hsize_t first_row, hsize_t num_rows, int* size);
+af_real* modis_read_band_rows(hid_t file, char* resolution, char** names, int num_groups, char* dnames[], int* band_indices, int band_size, hsize_t first_row, hsize_t num_rows, int* size);
+double* get_modis_attr(hid_t file, char* resolution, char* d_name, char* attr_name, int geo, void* attr_pt);
+char* get_modis_filename(char* resolution, char* band, int* band_index);
+af_real* modis_read_band_planes(hid_t file, char* resolution, char** names, int num_groups, char* dnames[], int* band_indices, int band_size, int* size);
+af_real* get_ceres_rad(hid_t file, char* camera, char* d_name, int* size);
+af_real* get_ceres_rad_rows(hid_t file, char* camera, char* d_name, int first_row, int num_rows, int* size);
+af_real* get_ceres_lat(hid_t file, char* camera, char* d_name, int* size);
+af_real* get_ceres_lat_rows(hid_t file, char* camera, char* d_name, int first_row, int num_rows, int* size);
+af_real* get_ceres_long(hid_t file, char* camera, char* d_name, int* size);
+af_real* get_ceres_long_rows(hid_t file, char* camera, char* d_name, int first_row, int num_rows, int* size);
+af_real* get_mop_rad(hid_t file, int* size);
+af_real* get_mop_rad_rows(hid_t file, int first_row, int num_rows, int* size);
+af_real* get_mop_lat(hid_t file, int*size);
+af_real* get_mop_lat_rows(hid_t file, int first_row, int num_rows, int* size);
+af_real* get_mop_long(hid_t file, int* size);
+af_real* get_mop_long_rows(hid_t file, int first_row, int num_rows, int* size);
+af_real* get_ast_rad(hid_t file, char* subsystem, char* d_name, int*size);
+af_real* get_ast_rad_rows(hid_t file, char* subsystem, char* d_name, int first_row, int num_rows, int* size);
+af_real* get_ast_lat(hid_t file, char* subsystem, char* d_name, int*size);
+af_real* get_ast_lat_rows(hid_t file, char* subsystem, char* d_name, int first_row, int num_rows, int* size);
+af_real* get_ast_long(hid_t file, char* subsystem, char* d_name, int*size);
+af_real* get_ast_long_rows(hid_t file, char* subsystem, char* d_name, int first_row, int num_rows, int* size);
+
+//Helper functions
+void concat_by_sep(char** source, const char** w, char* sep, size_t length, int arr_size);
+double dim_sum(hsize_t* dims, int arr_len);
+double float_to_double(float f);
+hid_t af_mem_type_id(af_mem_type mem_type);
+int af_check_type_class(hid_t dataset);
@@ -8,188 +8,522 @@
 #include<stdlib.h>
 #include<stdio.h>
 #include<math.h>
+#include"reproject.h"
+#ifdef _OPENMP
+#include<omp.h>
+#endif
 #ifndef M_PI
 #    define M_PI 3.14159265358979323846
 #endif
+#ifdef __GNUC__
+#    define PREFETCH(p) __builtin_prefetch(p)
+#else
+#    define PREFETCH(p)
+#endif
+//How many targets ahead the gathers prefetch the source rows
+#define PREFETCH_DISTANCE 16
+
+#ifdef AF_BENCH_STATS
+long long nnCandidateCount = 0;
+#endif
 
-int * pointIndexOnLat(double ** plat, double ** plon,  int * oriID, int count, int nBlockY) {
+//Latitude band of a point, -1 outside [-PI/2, PI/2]; the north pole belongs to the last band
+static int latBandOf(double lat, double blockR, int nBlockY) {
 
-	double *lat = *plat;
-	double *lon = *plon;
+	int blockID = (int)((lat + M_PI/2) / blockR);
+	if(blockID == nBlockY && lat <= M_PI/2) {
+		blockID = nBlockY - 1;
+	}
+	if(blockID < 0 || blockID >= nBlockY || lat < -M_PI/2) {
+		return -1;
+	}
+	return blockID;
+}
 
-	double blockR = M_PI/nBlockY;
+typedef struct {
+	int cell;
+	int id;
+} gridEntry;
 
-	int * index;
-	int * pointsInB;
-	
-	double * newLon;
-	double * newLat;
+//Everything a search builds, kept between calls so buffers are only reallocated when a call needs more room.
+//Sources are indexed in latitude bands, and within each band in longitude cells wide enough that a search
+//circle of radius centered in the band or its two neighbours spans at most three cells.
+struct nnWorkspace {
+	int nBlockY;
+	double blockR;
+	int nSorted;		//number of indexed sources (sources outside [-90, 90] are left out)
+	int maxBand;		//number of sources in the most populated band
+	int nThreads;
 
-	if(NULL == (index = (int *)malloc(sizeof(int) * (nBlockY + 1))))
-	{
+	int souCapacity;
+	int * souID;		//source IDs in grid order
+	int * cellID;		//longitude cell of each source in grid order
+	double * souX;		//unit vectors of the sources in grid order
+	double * souY;
+	double * souZ;
+
+	int bandCapacity;
+	int * bandIndex;	//start of each band in grid order, nBlockY + 1 entries
+	int * nLonCells;	//number of longitude cells in each band, 1 means scan the whole band
+	double * lonCellR;	//longitude width of the cells in each band
+
+	size_t countCapacity;
+	int * bandCount;	//per chunk band histograms of the counting sort
+
+	size_t entryCapacity;
+	gridEntry * entries;	//per thread sort buffers, maxBand each
+
+	size_t scratchCapacity;
+	double * chordDis;	//per thread candidate distances, 3 * maxBand each
+};
+
+static void * allocBuffer(size_t n, size_t size) {
+
+	void * buffer;
+	if(NULL == (buffer = malloc(size * (n > 0 ? n : 1)))) {
 		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
 		exit(1);
 	}
+	return buffer;
+}
 
-	if(NULL == (pointsInB = (int *)malloc(sizeof(int) * nBlockY)))
-	{
+static void * reserveBuffer(void * buffer, size_t * capacity, size_t needed, size_t size) {
+
+	if(needed < 1) {
+		needed = 1;
+	}
+	if(buffer != NULL && *capacity >= needed) {
+		return buffer;
+	}
+	free(buffer);
+	buffer = allocBuffer(needed, size);
+	*capacity = needed;
+	return buffer;
+}
+
+nnWorkspace * nnWorkspaceCreate() {
+
+	nnWorkspace * ws;
+	if(NULL == (ws = (nnWorkspace *)calloc(1, sizeof(nnWorkspace)))) {
 		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
 		exit(1);
 	}
-	int i;
-	for(i = 0; i < nBlockY; i++)
-	{
-		pointsInB[i] = 0;
+	return ws;
+}
+
+void nnWorkspaceFree(nnWorkspace * ws) {
+
+	if(ws == NULL) {
+		return;
+	}
+	free(ws->souID);
+	free(ws->cellID);
+	free(ws->souX);
+	free(ws->souY);
+	free(ws->souZ);
+	free(ws->bandIndex);
+	free(ws->nLonCells);
+	free(ws->lonCellR);
+	free(ws->bandCount);
+	free(ws->entries);
+	free(ws->chordDis);
+	free(ws);
+}
+
+//Per source and per band arrays only grow, so repeated calls of similar size allocate nothing
+static void reserveSources(nnWorkspace * ws, int nSou) {
+
+	if(ws->souID == NULL || ws->souCapacity < nSou) {
+		free(ws->souID);
+		free(ws->cellID);
+		free(ws->souX);
+		free(ws->souY);
+		free(ws->souZ);
+		ws->souID = (int *)allocBuffer(nSou, sizeof(int));
+		ws->cellID = (int *)allocBuffer(nSou, sizeof(int));
+		ws->souX = (double *)allocBuffer(nSou, sizeof(double));
+		ws->souY = (double *)allocBuffer(nSou, sizeof(double));
+		ws->souZ = (double *)allocBuffer(nSou, sizeof(double));
+		ws->souCapacity = nSou;
+	}
+	if(ws->bandIndex == NULL || ws->bandCapacity < ws->nBlockY + 1) {
+		free(ws->bandIndex);
+		free(ws->nLonCells);
+		free(ws->lonCellR);
+		ws->bandIndex = (int *)allocBuffer(ws->nBlockY + 1, sizeof(int));
+		ws->nLonCells = (int *)allocBuffer(ws->nBlockY + 1, sizeof(int));
+		ws->lonCellR = (double *)allocBuffer(ws->nBlockY + 1, sizeof(double));
+		ws->bandCapacity = ws->nBlockY + 1;
 	}
+}
+
+//Parallel counting sort of the sources into latitude bands: each chunk of points counts and scatters its own
+//points, chunks in order, so the result is the same stable order as a serial pass whatever the number of threads
+static void pointIndexOnLat(nnWorkspace * ws, const af_real * lat, int count) {
+
+	int nBlockY = ws->nBlockY;
+	double blockR = ws->blockR;
+	int * index = ws->bandIndex;
+	int * oriID = ws->souID;
+
+	int nChunks = ws->nThreads;
+	if(nChunks > count) {
+		nChunks = count > 0 ? count : 1;
+	}
+	ws->bandCount = (int *)reserveBuffer(ws->bandCount, &ws->countCapacity, (size_t)nChunks * nBlockY, sizeof(int));
+	int * pointsInB = ws->bandCount;
 
-	int blockID;
-	int j;	
-	for(j = 0; j < count; j++) {
-	
-		blockID = (int)((lat[j] + M_PI/2) / blockR);
-		
-		if(blockID >= 0 && blockID < nBlockY) {
-			pointsInB[blockID] ++;
+	int t;
+	#pragma omp parallel for schedule(static)
+	for(t = 0; t < nChunks; t++) {
+		int * chunkCount = pointsInB + (size_t)t * nBlockY;
+		int start = (int)((long long)count * t / nChunks);
+		int end = (int)((long long)count * (t + 1) / nChunks);
+		int j;
+		for(j = 0; j < nBlockY; j++) {
+			chunkCount[j] = 0;
+		}
+		for(j = start; j < end; j++) {
+			int blockID = latBandOf(lat[j] * M_PI / 180, blockR, nBlockY);
+			if(blockID >= 0) {
+				chunkCount[blockID] ++;
+			}
 		}
 	}
 
+	//Band starts, then each chunk's start within every band
 	index[0] = 0;
 	int k;
-	for(k = 1; k < nBlockY + 1; k++) {
-		index[k] = index[k - 1] + pointsInB[k - 1];
+	for(k = 0; k < nBlockY; k++) {
+		int offset = index[k];
+		for(t = 0; t < nChunks; t++) {
+			int c = pointsInB[(size_t)t * nBlockY + k];
+			pointsInB[(size_t)t * nBlockY + k] = offset;
+			offset += c;
+		}
+		index[k + 1] = offset;
 	}
 
-	if(NULL == (newLon = (double *)malloc(sizeof(double) * index[nBlockY]))) {
-		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
-		exit(1);
-	} 
-	if(NULL == (newLat = (double *)malloc(sizeof(double) * index[nBlockY]))) {
-		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
-		exit(1);
+	#pragma omp parallel for schedule(static)
+	for(t = 0; t < nChunks; t++) {
+		int * chunkOffset = pointsInB + (size_t)t * nBlockY;
+		int start = (int)((long long)count * t / nChunks);
+		int end = (int)((long long)count * (t + 1) / nChunks);
+		int n;
+		for(n = start; n < end; n++) {
+			int blockID = latBandOf(lat[n] * M_PI / 180, blockR, nBlockY);
+			if(blockID >= 0) {
+				oriID[chunkOffset[blockID]] = n;
+				chunkOffset[blockID] ++;
+			}
+		}
 	}
-	
-	pointsInB[0] = 0;
-	int m;
-	for(m = 1; m < nBlockY; m++) {
-		pointsInB[m] = index[m];
+
+	ws->nSorted = index[nBlockY];
+}
+
+static int compareGridEntry(const void * a, const void * b) {
+
+	const gridEntry * ea = (const gridEntry *)a;
+	const gridEntry * eb = (const gridEntry *)b;
+	if(ea->cell != eb->cell) {
+		return ea->cell < eb->cell ? -1 : 1;
 	}
-	int n;
-	for(n = 0; n < count; n++) {
-		
-		blockID = (int)((lat[n] + M_PI/2) / blockR);
-		if(blockID >= 0 && blockID < nBlockY) {
-			newLon[pointsInB[blockID]] = lon[n];
-			newLat[pointsInB[blockID]] = lat[n];
-			oriID[pointsInB[blockID]] = n;
-			pointsInB[blockID] ++;
-	
-		}
+	return ea->id < eb->id ? -1 : (ea->id > eb->id);
+}
+
+static int lonCellOf(double lon, double cellR, int nCells) {
+
+	int cell = (int)floor((lon + M_PI) / cellR);
+	cell = cell % nCells;
+	if(cell < 0) {
+		cell += nCells;
 	}
-	
+	return cell;
+}
+
+//Sorts the (already latitude banded) sources by longitude cell within each band
+static void lonCellsInBands(nnWorkspace * ws, const af_real * lon, double radius) {
+
+	int nBlockY = ws->nBlockY;
+	double blockR = ws->blockR;
+
+	int maxBand = 0;
+	int k;
+	for(k = 0; k < nBlockY; k++) {
+
+		//Highest absolute latitude a target searching this band can have
+		double lowEdge = fabs(-M_PI / 2 + (k - 1) * blockR);
+		double highEdge = fabs(-M_PI / 2 + (k + 2) * blockR);
+		double maxLat = lowEdge > highEdge ? lowEdge : highEdge;
+
+		int nCells = 1;
+		if(maxLat + radius < M_PI / 2) {
+			double halfWidth = asin(sin(radius) / cos(maxLat));
+			nCells = (int)(2 * M_PI / halfWidth);
+			//Polar caps and very wide circles: the whole band is one cell
+			if(nCells < 3) {
+				nCells = 1;
+			}
+		}
+		ws->nLonCells[k] = nCells;
+		ws->lonCellR[k] = 2 * M_PI / nCells;
 
+		int bandSize = ws->bandIndex[k + 1] - ws->bandIndex[k];
+		if(bandSize > maxBand) {
+			maxBand = bandSize;
+		}
+	}
+	ws->maxBand = maxBand;
+	ws->entries = (gridEntry *)reserveBuffer(ws->entries, &ws->entryCapacity, (size_t)ws->nThreads * maxBand, sizeof(gridEntry));
 
-	free(pointsInB);
-	free(lon);
-	free(lat);
+	//Bands are sorted independently; sizes vary a lot along the swath, hence the dynamic schedule
+	#pragma omp parallel
+	{
+		gridEntry * entries = ws->entries;
+#ifdef _OPENMP
+		entries += (size_t)omp_get_thread_num() * maxBand;
+#endif
+		int band;
+		#pragma omp for schedule(dynamic, 16)
+		for(band = 0; band < nBlockY; band++) {
 
-	count = index[nBlockY];
-	*plon = newLon;
-	*plat = newLat;
+			int start = ws->bandIndex[band];
+			int bandSize = ws->bandIndex[band + 1] - start;
+			int i;
+			if(ws->nLonCells[band] == 1) {
+				for(i = 0; i < bandSize; i++) {
+					ws->cellID[start + i] = 0;
+				}
+				continue;
+			}
+			for(i = 0; i < bandSize; i++) {
+				int id = ws->souID[start + i];
+				entries[i].cell = lonCellOf(lon[id] * M_PI / 180, ws->lonCellR[band], ws->nLonCells[band]);
+				entries[i].id = id;
+			}
+			qsort(entries, bandSize, sizeof(gridEntry), compareGridEntry);
+			for(i = 0; i < bandSize; i++) {
+				ws->cellID[start + i] = entries[i].cell;
+				ws->souID[start + i] = entries[i].id;
+			}
+		}
+	}
+}
 
-//	printf("%0x\n", lat);
+//First position in [start, end) whose cell is not less than cell
+static int lowerBoundCell(const int * cellID, int start, int end, int cell) {
 
-	return index;
+	while(start < end) {
+		int mid = start + (end - start) / 2;
+		if(cellID[mid] < cell) {
+			start = mid + 1;
+		}
+		else {
+			end = mid;
+		}
+	}
+	return start;
 }
 
 //Finding the nearest neiboring point's ID 
-void nearestNeighbor(double ** psouLat, double ** psouLon, int nSou, double * tarLat, double * tarLon, int * tarNNSouID, int nTar, double maxR) {
-
-	//printf("%0x\n", souLat);
-	double * souLat = *psouLat;
-	double * souLon = *psouLon;
+void nearestNeighborConst(nnWorkspace * ws, const af_real * souLat, const af_real * souLon, int nSou, const af_real * tarLat, const af_real * tarLon, int * tarNNSouID, int nTar, double maxR) {
 
 	const double earthRadius = 6367444;
 	double radius = maxR / earthRadius;
 	int nBlockY = M_PI / radius;
+	if(nBlockY < 1) {
+		nBlockY = 1;
+	}
 
 	double blockR = M_PI / nBlockY;
-	
-	int i;
-	for(i = 0; i < nSou; i++) {
-		souLat[i] = souLat[i] * M_PI / 180;
-		souLon[i] = souLon[i] * M_PI / 180;
-	}
-	int j;
-	for(j = 0; j < nTar; j++) {
-		tarLat[j] = tarLat[j] * M_PI / 180;
-		tarLon[j] = tarLon[j] * M_PI / 180;
-	}
 
-	int * souID;
-	if(NULL == (souID = (int *)malloc(sizeof(double) * nSou))) {
-		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
-		exit(1);
+	ws->nBlockY = nBlockY;
+	ws->blockR = blockR;
+	ws->nThreads = 1;
+#ifdef _OPENMP
+	ws->nThreads = omp_get_max_threads();
+#endif
+	reserveSources(ws, nSou);
+	pointIndexOnLat(ws, souLat, nSou);
+	lonCellsInBands(ws, souLon, radius);
+
+	//Unit vectors of the sources in grid order; a distance of radius is a chord of length 2 sin(radius / 2)
+	int nSorted = ws->nSorted;
+	int * souID = ws->souID;
+	double * souX = ws->souX;
+	double * souY = ws->souY;
+	double * souZ = ws->souZ;
+	int n;
+	#pragma omp parallel for schedule(static)
+	for(n = 0; n < nSorted; n++) {
+		double sLat = souLat[souID[n]] * M_PI / 180;
+		double sLon = souLon[souID[n]] * M_PI / 180;
+		double cosLat = cos(sLat);
+		souX[n] = cosLat * cos(sLon);
+		souY[n] = cosLat * sin(sLon);
+		souZ[n] = sin(sLat);
 	}
-	int * souIndex = pointIndexOnLat(psouLat, psouLon, souID, nSou, nBlockY);
-	souLat = *psouLat;
-	souLon = *psouLon;
+	double maxChord = 2 * sin(radius / 2);
+	maxChord = maxChord * maxChord;
 
-	double tLat, tLon;
-	double sLat, sLon;
-	int blockID;
-	int startBlock, endBlock;
+	size_t perThread = 3 * (size_t)ws->maxBand;
+	ws->chordDis = (double *)reserveBuffer(ws->chordDis, &ws->scratchCapacity, (size_t)ws->nThreads * perThread, sizeof(double));
 
-	double pDis;	
-	double nnDis;
-	int nnSouID;
-	int m;
-	for(m = 0; m < nTar; m ++) {
+	//Targets are independent; their candidate counts vary along the swath, hence the dynamic schedule
+	#pragma omp parallel
+	{
+		//Squared chords of the candidates of one target, at most three bands
+		double * chordDis = ws->chordDis;
+#ifdef _OPENMP
+		chordDis += (size_t)omp_get_thread_num() * perThread;
+#endif
+		const int * bandIndex = ws->bandIndex;
+		const int * cellID = ws->cellID;
 
-		tLat = tarLat[m];
-		tLon = tarLon[m];
+		double tLat, tLon;
+		double tX, tY, tZ;
+		int blockID;
+		int startBlock, endBlock;
 
-		blockID = (tLat + M_PI / 2) / blockR;
-		startBlock = blockID - 1;
-		endBlock = blockID + 1;
+		double nnDis;
+		int nnSouID;
+		int m;
+#ifdef AF_BENCH_STATS
+		long long candidates = 0;
+#endif
+		#pragma omp for schedule(dynamic, 256)
+		for(m = 0; m < nTar; m ++) {
 
-		if(startBlock < 0) {
-			startBlock = 0;
-		}
-		if(endBlock > nBlockY - 1) {
-			endBlock = nBlockY - 1;
-		}
+			tLat = tarLat[m] * M_PI / 180;
+			tLon = tarLon[m] * M_PI / 180;
+			tX = cos(tLat) * cos(tLon);
+			tY = cos(tLat) * sin(tLon);
+			tZ = sin(tLat);
 
-		nnDis = -1;
-		int n;
-		for(n = souIndex[startBlock]; n < souIndex[endBlock+1]; n++) {
-			
-			sLat = souLat[n];
-			sLon = souLon[n];
+			blockID = (tLat + M_PI / 2) / blockR;
+			startBlock = blockID - 1;
+			endBlock = blockID + 1;
 
-			pDis = acos(sin(tLat) * sin(sLat) + cos(tLat) * cos(sLat) * cos(tLon - sLon));
-				
-			if((nnDis < 0 || nnDis > pDis) && pDis <= radius) {
-				nnDis = pDis;
-				nnSouID = souID[n];
+			if(startBlock < 0) {
+				startBlock = 0;
+			}
+			if(endBlock > nBlockY - 1) {
+				endBlock = nBlockY - 1;
+			}
+
+			//At most two index ranges per band: cells c-1..c+1, split where they wrap at the dateline
+			int ranges[6][2];
+			int nRanges = 0;
+			int k;
+			for(k = startBlock; k <= endBlock; k++) {
+
+				int bandStart = bandIndex[k];
+				int bandEnd = bandIndex[k + 1];
+				int nCells = ws->nLonCells[k];
+				if(nCells == 1) {
+					ranges[nRanges][0] = bandStart;
+					ranges[nRanges][1] = bandEnd;
+					nRanges ++;
+				}
+				else {
+					int cell = lonCellOf(tLon, ws->lonCellR[k], nCells);
+					int first = cell - 1;
+					int last = cell + 1;
+					if(first < 0) {
+						ranges[nRanges][0] = lowerBoundCell(cellID, bandStart, bandEnd, nCells - 1);
+						ranges[nRanges][1] = bandEnd;
+						nRanges ++;
+						first = 0;
+					}
+					else if(last > nCells - 1) {
+						ranges[nRanges][0] = bandStart;
+						ranges[nRanges][1] = lowerBoundCell(cellID, bandStart, bandEnd, 1);
+						nRanges ++;
+						last = nCells - 1;
+					}
+					ranges[nRanges][0] = lowerBoundCell(cellID, bandStart, bandEnd, first);
+					ranges[nRanges][1] = lowerBoundCell(cellID, ranges[nRanges][0], bandEnd, last + 1);
+					nRanges ++;
+				}
+			}
+
+			//First pass: squared chords of all candidates and their minimum
+			nnDis = maxChord;
+			int nCand = 0;
+			int r, c;
+			for(r = 0; r < nRanges; r++) {
+				int start = ranges[r][0];
+				int len = ranges[r][1] - start;
+				double * dis = chordDis + nCand;
+				#pragma omp simd reduction(min:nnDis)
+				for(c = 0; c < len; c++) {
+					double dx = souX[start + c] - tX;
+					double dy = souY[start + c] - tY;
+					double dz = souZ[start + c] - tZ;
+					double d = dx * dx + dy * dy + dz * dz;
+					dis[c] = d;
+					nnDis = d < nnDis ? d : nnDis;
+				}
+				nCand += len;
+			}
+
+			//Second pass: the smallest source ID at that distance, so ties do not depend on scan order
+			nnSouID = -1;
+			nCand = 0;
+			for(r = 0; r < nRanges; r++) {
+				int start = ranges[r][0];
+				int len = ranges[r][1] - start;
+				double * dis = chordDis + nCand;
+				for(c = 0; c < len; c++) {
+					if(dis[c] == nnDis && (nnSouID < 0 || souID[start + c] < nnSouID)) {
+						nnSouID = souID[start + c];
+					}
+				}
+				nCand += len;
 			}
-				
-		}
 
-		if(nnDis < 0) {
-			tarNNSouID[m] = -1;
-		}
-		else {
 			tarNNSouID[m] = nnSouID;
+#ifdef AF_BENCH_STATS
+			candidates += nCand;
+#endif
 		}
-	
-		 
+#ifdef AF_BENCH_STATS
+		#pragma omp atomic
+		nnCandidateCount += candidates;
+#endif
+	}
+}
+
+#ifdef AF_BENCH_STATS
+void nnBenchIndexOnLat(nnWorkspace * ws, const af_real * souLat, int nSou, double maxR) {
+
+	const double earthRadius = 6367444;
+	double radius = maxR / earthRadius;
+	int nBlockY = M_PI / radius;
+	if(nBlockY < 1) {
+		nBlockY = 1;
 	}
-	
-	return;	
+	ws->nBlockY = nBlockY;
+	ws->blockR = M_PI / nBlockY;
+	ws->nThreads = 1;
+#ifdef _OPENMP
+	ws->nThreads = omp_get_max_threads();
+#endif
+	reserveSources(ws, nSou);
+	pointIndexOnLat(ws, souLat, nSou);
+}
+#endif
+
+void nearestNeighbor(af_real ** psouLat, af_real ** psouLon, int nSou, af_real * tarLat, af_real * tarLon, int * tarNNSouID, int nTar, double maxR) {
+
+	nnWorkspace * ws = nnWorkspaceCreate();
+	nearestNeighborConst(ws, *psouLat, *psouLon, nSou, tarLat, tarLon, tarNNSouID, nTar, maxR);
+	nnWorkspaceFree(ws);
 }
 
 
-void nnInterpolate(double * souVal, double * tarVal, int * tarNNSouID, int nTar) {
+void nnInterpolate(af_real * souVal, af_real * tarVal, int * tarNNSouID, int nTar) {
 
 	int nnSouID;
 	int i;
@@ -204,34 +538,1235 @@ void nnInterpolate(double * souVal, double * tarVal, int * tarNNSouID, int nTar)
 	}
 }
 
-void summaryInterpolate(double * souVal, int * souNNTarID, int nSou, double * tarVal, int * nSouPixels, int nTar) {
-	int i;
-	for(i = 0; i < nTar; i++) {
-	
-		tarVal[i] = 0;
-		nSouPixels[i] = 0;
+//Groups the sources by target: the sources of target k are tarSou[tarStart[k]] .. tarSou[tarStart[k + 1] - 1],
+//in ascending order. Same parallel counting sort as "pointIndexOnLat", so sums taken in this order are the
+//serial sums bit for bit, whatever the number of threads
+static void sourcesByTarget(const int * souNNTarID, int nSou, int nTar, int * tarStart, int * tarSou) {
+
+	int nChunks = 1;
+#ifdef _OPENMP
+	nChunks = omp_get_max_threads();
+#endif
+	if(nChunks > nSou) {
+		nChunks = nSou > 0 ? nSou : 1;
+	}
+	int * chunkCounts;
+	if(NULL == (chunkCounts = (int *)malloc(sizeof(int) * (size_t)nChunks * (nTar > 0 ? nTar : 1)))) {
+		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
+		exit(1);
+	}
+
+	int t;
+	#pragma omp parallel for schedule(static)
+	for(t = 0; t < nChunks; t++) {
+		int * chunkCount = chunkCounts + (size_t)t * nTar;
+		int start = (int)((long long)nSou * t / nChunks);
+		int end = (int)((long long)nSou * (t + 1) / nChunks);
+		int j;
+		for(j = 0; j < nTar; j++) {
+			chunkCount[j] = 0;
+		}
+		for(j = start; j < end; j++) {
+			int nnTarID = souNNTarID[j];
+			if(nnTarID >= 0 && nnTarID < nTar) {
+				chunkCount[nnTarID] ++;
+			}
+		}
+	}
+
+	//Target starts, then each chunk's start within every target
+	tarStart[0] = 0;
+	int k;
+	for(k = 0; k < nTar; k++) {
+		int offset = tarStart[k];
+		for(t = 0; t < nChunks; t++) {
+			int c = chunkCounts[(size_t)t * nTar + k];
+			chunkCounts[(size_t)t * nTar + k] = offset;
+			offset += c;
+		}
+		tarStart[k + 1] = offset;
 	}
 
-	int nnTarID;
-	int j;
-	for(j = 0; j < nSou; j++) {
-		
-		nnTarID = souNNTarID[j];
-		if(nnTarID > 0 && souVal[j] >= 0) {
-			tarVal[nnTarID] += souVal[j];
-			nSouPixels[nnTarID] ++;	
+	#pragma omp parallel for schedule(static)
+	for(t = 0; t < nChunks; t++) {
+		int * chunkOffset = chunkCounts + (size_t)t * nTar;
+		int start = (int)((long long)nSou * t / nChunks);
+		int end = (int)((long long)nSou * (t + 1) / nChunks);
+		int j;
+		for(j = start; j < end; j++) {
+			int nnTarID = souNNTarID[j];
+			if(nnTarID >= 0 && nnTarID < nTar) {
+				tarSou[chunkOffset[nnTarID]] = j;
+				chunkOffset[nnTarID] ++;
+			}
 		}
 	}
 
+	free(chunkCounts);
+}
+
+static void allocTargetGroups(int nSou, int nTar, int ** tarStart, int ** tarSou) {
+
+	if(NULL == (*tarStart = (int *)malloc(sizeof(int) * ((size_t)nTar + 1)))) {
+		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
+		exit(1);
+	}
+	if(NULL == (*tarSou = (int *)malloc(sizeof(int) * (nSou > 0 ? nSou : 1)))) {
+		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
+		exit(1);
+	}
+}
+
+//Each target sums its own sources in source order: no shared accumulators, and the same result as the serial scatter
+void summaryInterpolate(af_real * souVal, int * souNNTarID, int nSou, af_real * tarVal, int * nSouPixels, int nTar) {
+
 	int k;
+#ifdef _OPENMP
+	if(omp_get_max_threads() == 1)
+#endif
+	{
+		//One thread: the plain scatter, which the grouped sums reproduce exactly
+		for(k = 0; k < nTar; k++) {
+			tarVal[k] = 0;
+			nSouPixels[k] = 0;
+		}
+		int j;
+		for(j = 0; j < nSou; j++) {
+			int nnTarID = souNNTarID[j];
+			if(nnTarID >= 0 && nnTarID < nTar && souVal[j] >= 0) {
+				tarVal[nnTarID] += souVal[j];
+				nSouPixels[nnTarID] ++;
+			}
+		}
+		for(k = 0; k < nTar; k++) {
+			if(nSouPixels[k] > 0) {
+				tarVal[k] = tarVal[k] / nSouPixels[k];
+			}
+			else {
+				tarVal[k] = -999;
+			}
+		}
+		return;
+	}
+
+	int * tarStart;
+	int * tarSou;
+	allocTargetGroups(nSou, nTar, &tarStart, &tarSou);
+	sourcesByTarget(souNNTarID, nSou, nTar, tarStart, tarSou);
+
+	#pragma omp parallel for schedule(dynamic, 1024)
 	for(k = 0; k < nTar; k++) {
-	
-		if(nSouPixels[k] > 0) {
-			tarVal[k] = tarVal[k] / nSouPixels[k];
+		af_real sum = 0;
+		int count = 0;
+		int n;
+		for(n = tarStart[k]; n < tarStart[k + 1]; n++) {
+			af_real v = souVal[tarSou[n]];
+			if(v >= 0) {
+				sum += v;
+				count ++;
+			}
+		}
+		nSouPixels[k] = count;
+		if(count > 0) {
+			tarVal[k] = sum / count;
 		}
 		else {
 			tarVal[k] = -999;
 		}
 	}
 
+	free(tarStart);
+	free(tarSou);
+}
+
+void nnInterpolateBands(af_real ** souVals, int nBands, af_real * tarVal, int * tarNNSouID, int nTar) {
+
+	//Targets go in blocks: the block's IDs stay in L1 while every band gathers through them
+	const int block = 256;
+	int start;
+	#pragma omp parallel for schedule(static)
+	for(start = 0; start < nTar; start += block) {
+		int end = start + block < nTar ? start + block : nTar;
+		int b;
+		for(b = 0; b < nBands; b++) {
+			const af_real * band = souVals[b];
+			af_real * out = tarVal + b;
+			int i;
+			for(i = start; i < end; i++) {
+				if(i + PREFETCH_DISTANCE < end && tarNNSouID[i + PREFETCH_DISTANCE] >= 0) {
+					PREFETCH(band + tarNNSouID[i + PREFETCH_DISTANCE]);
+				}
+				int nnSouID = tarNNSouID[i];
+				out[(size_t)i * nBands] = nnSouID < 0 ? -999 : band[nnSouID];
+			}
+		}
+	}
+}
+
+void nnInterpolateCube(af_real * souCube, int nBands, af_real * tarVal, int * tarNNSouID, int nTar) {
+
+	int i;
+	#pragma omp parallel for schedule(static)
+	for(i = 0; i < nTar; i++) {
+		if(i + PREFETCH_DISTANCE < nTar && tarNNSouID[i + PREFETCH_DISTANCE] >= 0) {
+			PREFETCH(souCube + (size_t)tarNNSouID[i + PREFETCH_DISTANCE] * nBands);
+		}
+
+		af_real * row = tarVal + (size_t)i * nBands;
+		int nnSouID = tarNNSouID[i];
+		int b;
+		if(nnSouID < 0) {
+			for(b = 0; b < nBands; b++) {
+				row[b] = -999;
+			}
+		}
+		else {
+			const af_real * souRow = souCube + (size_t)nnSouID * nBands;
+			#pragma omp simd
+			for(b = 0; b < nBands; b++) {
+				row[b] = souRow[b];
+			}
+		}
+	}
+}
+
+void summaryInterpolateBands(af_real ** souVals, int nBands, int * souNNTarID, int nSou, af_real * tarVal, int * nSouPixels, int nTar) {
+
+	int * tarStart;
+	int * tarSou;
+	allocTargetGroups(nSou, nTar, &tarStart, &tarSou);
+	sourcesByTarget(souNNTarID, nSou, nTar, tarStart, tarSou);
+
+	int k;
+	#pragma omp parallel for schedule(dynamic, 1024)
+	for(k = 0; k < nTar; k++) {
+		af_real * row = tarVal + (size_t)k * nBands;
+		int * count = nSouPixels + (size_t)k * nBands;
+		int b;
+		for(b = 0; b < nBands; b++) {
+			row[b] = 0;
+			count[b] = 0;
+		}
+		int n;
+		for(n = tarStart[k]; n < tarStart[k + 1]; n++) {
+			int j = tarSou[n];
+			for(b = 0; b < nBands; b++) {
+				af_real v = souVals[b][j];
+				if(v >= 0) {
+					row[b] += v;
+					count[b] ++;
+				}
+			}
+		}
+		for(b = 0; b < nBands; b++) {
+			if(count[b] > 0) {
+				row[b] = row[b] / count[b];
+			}
+			else {
+				row[b] = -999;
+			}
+		}
+	}
+
+	free(tarStart);
+	free(tarSou);
+}
+
+summaryStats * summaryStatsCreate(int nTar) {
+
+	summaryStats * stats;
+	size_t n = nTar > 0 ? nTar : 1;
+	if(NULL == (stats = (summaryStats *)malloc(sizeof(summaryStats)))) {
+		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
+		exit(1);
+	}
+	stats->nTar = nTar;
+	if(NULL == (stats->mean = (af_real *)malloc(sizeof(af_real) * n)) ||
+	   NULL == (stats->std = (af_real *)malloc(sizeof(af_real) * n)) ||
+	   NULL == (stats->min = (af_real *)malloc(sizeof(af_real) * n)) ||
+	   NULL == (stats->max = (af_real *)malloc(sizeof(af_real) * n)) ||
+	   NULL == (stats->count = (int *)malloc(sizeof(int) * n))) {
+		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
+		exit(1);
+	}
+	return stats;
+}
+
+void summaryStatsFree(summaryStats * stats) {
+
+	if(stats == NULL) {
+		return;
+	}
+	free(stats->mean);
+	free(stats->std);
+	free(stats->min);
+	free(stats->max);
+	free(stats->count);
+	free(stats);
+}
+
+//Running statistics of one target; kept together so a scattered update touches one cache line
+typedef struct {
+	af_real mean;
+	af_real m2;		//sum of squared deviations from the mean
+	af_real min;
+	af_real max;
+	int count;
+} welfordAcc;
+
+static inline void welfordAdd(welfordAcc * acc, af_real v) {
+
+	acc->count ++;
+	af_real delta = v - acc->mean;
+	acc->mean += delta / acc->count;
+	acc->m2 += delta * (v - acc->mean);
+	if(v < acc->min) {
+		acc->min = v;
+	}
+	if(v > acc->max) {
+		acc->max = v;
+	}
+}
+
+static inline void welfordStore(const welfordAcc * acc, summaryStats * stats, int k) {
+
+	stats->count[k] = acc->count;
+	if(acc->count > 0) {
+		stats->mean[k] = acc->mean;
+		stats->std[k] = sqrt(acc->m2 / acc->count);
+		stats->min[k] = acc->min;
+		stats->max[k] = acc->max;
+	}
+	else {
+		stats->mean[k] = -999;
+		stats->std[k] = -999;
+		stats->min[k] = -999;
+		stats->max[k] = -999;
+	}
+}
+
+static const welfordAcc emptyAcc = {0, 0, HUGE_VAL, -HUGE_VAL, 0};
+
+//Same scheme as "summaryInterpolate": a streaming scatter on one thread, otherwise targets in parallel over
+//their grouped sources. Both feed each target its values in source order, so both give the same bits
+void summaryInterpolateStats(af_real * souVal, int * souNNTarID, int nSou, summaryStats * stats) {
+
+	int nTar = stats->nTar;
+	int k;
+#ifdef _OPENMP
+	if(omp_get_max_threads() == 1)
+#endif
+	{
+		welfordAcc * acc;
+		if(NULL == (acc = (welfordAcc *)malloc(sizeof(welfordAcc) * (nTar > 0 ? nTar : 1)))) {
+			printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
+			exit(1);
+		}
+		for(k = 0; k < nTar; k++) {
+			acc[k] = emptyAcc;
+		}
+		int j;
+		for(j = 0; j < nSou; j++) {
+			int nnTarID = souNNTarID[j];
+			if(nnTarID >= 0 && nnTarID < nTar && souVal[j] >= 0) {
+				welfordAdd(acc + nnTarID, souVal[j]);
+			}
+		}
+		for(k = 0; k < nTar; k++) {
+			welfordStore(acc + k, stats, k);
+		}
+		free(acc);
+		return;
+	}
+
+	int * tarStart;
+	int * tarSou;
+	allocTargetGroups(nSou, nTar, &tarStart, &tarSou);
+	sourcesByTarget(souNNTarID, nSou, nTar, tarStart, tarSou);
+
+	#pragma omp parallel for schedule(dynamic, 1024)
+	for(k = 0; k < nTar; k++) {
+		welfordAcc acc = emptyAcc;
+		int n;
+		for(n = tarStart[k]; n < tarStart[k + 1]; n++) {
+			af_real v = souVal[tarSou[n]];
+			if(v >= 0) {
+				welfordAdd(&acc, v);
+			}
+		}
+		welfordStore(&acc, stats, k);
+	}
+
+	free(tarStart);
+	free(tarSou);
+}
+
+void idwInterpolate(af_real * souVal, af_real * tarVal, int * tarKNNSouID, double * tarKNNDis, int nTar, int k, double power) {
+
+	int i;
+	#pragma omp parallel for schedule(static)
+	for(i = 0; i < nTar; i++) {
+		const int * souID = tarKNNSouID + (size_t)i * k;
+		const double * souDis = tarKNNDis + (size_t)i * k;
+		double sum = 0;
+		double weights = 0;
+		int exact = 0;
+		int j;
+		for(j = 0; j < k && souID[j] >= 0; j++) {
+			af_real v = souVal[souID[j]];
+			if(v < 0) {
+				continue;
+			}
+			//Neighbors come nearest first, so a zero distance is the first valid one
+			if(souDis[j] == 0) {
+				sum = v;
+				weights = 1;
+				exact = 1;
+				break;
+			}
+			double w = power == 2 ? 1 / (souDis[j] * souDis[j]) : pow(souDis[j], -power);
+			sum += w * v;
+			weights += w;
+		}
+		if(exact || weights > 0) {
+			tarVal[i] = sum / weights;
+		}
+		else {
+			tarVal[i] = -999;
+		}
+	}
+}
+
+static void cellVector(const af_real * lat, const af_real * lon, int id, double * v) {
+
+	double cLat = lat[id] * M_PI / 180;
+	double cLon = lon[id] * M_PI / 180;
+	v[0] = cos(cLat) * cos(cLon);
+	v[1] = cos(cLat) * sin(cLon);
+	v[2] = sin(cLat);
+}
+
+static double dot3(const double * a, const double * b) {
+
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+void bilinearInterpolate(af_real * souLat, af_real * souLon, af_real * souVal, int nRows, int nCols, af_real * tarLat, af_real * tarLon, int * tarNNSouID, af_real * tarVal, int nTar) {
+
+	int i;
+	#pragma omp parallel for schedule(static)
+	for(i = 0; i < nTar; i++) {
+		int nnSouID = tarNNSouID[i];
+		if(nnSouID < 0) {
+			tarVal[i] = -999;
+			continue;
+		}
+		if(nRows < 2 || nCols < 2) {
+			tarVal[i] = souVal[nnSouID];
+			continue;
+		}
+
+		double q[3];
+		double p[3];
+		double tLat = tarLat[i] * M_PI / 180;
+		double tLon = tarLon[i] * M_PI / 180;
+		q[0] = cos(tLat) * cos(tLon);
+		q[1] = cos(tLat) * sin(tLon);
+		q[2] = sin(tLat);
+		cellVector(souLat, souLon, nnSouID, p);
+
+		//The quad lies on the target's side of the nearest cell along the row and column directions
+		int r = nnSouID / nCols;
+		int c = nnSouID % nCols;
+		double along[3];
+		double off[3];
+		int n;
+		for(n = 0; n < 3; n++) {
+			off[n] = q[n] - p[n];
+		}
+		double e[3];
+		double f[3];
+		cellVector(souLat, souLon, r * nCols + (c + 1 < nCols ? c + 1 : c), e);
+		cellVector(souLat, souLon, r * nCols + (c > 0 ? c - 1 : c), f);
+		for(n = 0; n < 3; n++) {
+			along[n] = e[n] - f[n];
+		}
+		int c0 = dot3(off, along) >= 0 ? c : c - 1;
+		cellVector(souLat, souLon, (r + 1 < nRows ? r + 1 : r) * nCols + c, e);
+		cellVector(souLat, souLon, (r > 0 ? r - 1 : r) * nCols + c, f);
+		for(n = 0; n < 3; n++) {
+			along[n] = e[n] - f[n];
+		}
+		int r0 = dot3(off, along) >= 0 ? r : r - 1;
+		if(c0 < 0) c0 = 0;
+		if(c0 > nCols - 2) c0 = nCols - 2;
+		if(r0 < 0) r0 = 0;
+		if(r0 > nRows - 2) r0 = nRows - 2;
+
+		//Fractional position in the quad: least squares on its two edge vectors, clamped to the quad
+		int corner[4];
+		corner[0] = r0 * nCols + c0;
+		corner[1] = corner[0] + 1;
+		corner[2] = corner[0] + nCols;
+		corner[3] = corner[2] + 1;
+		double p00[3];
+		double a[3];
+		double b[3];
+		cellVector(souLat, souLon, corner[0], p00);
+		cellVector(souLat, souLon, corner[1], a);
+		cellVector(souLat, souLon, corner[2], b);
+		for(n = 0; n < 3; n++) {
+			a[n] -= p00[n];
+			b[n] -= p00[n];
+			off[n] = q[n] - p00[n];
+		}
+		double aa = dot3(a, a);
+		double bb = dot3(b, b);
+		double ab = dot3(a, b);
+		double det = aa * bb - ab * ab;
+		double u = 0;
+		double v = 0;
+		if(det > 0) {
+			double qa = dot3(off, a);
+			double qb = dot3(off, b);
+			u = (qa * bb - qb * ab) / det;
+			v = (qb * aa - qa * ab) / det;
+		}
+		u = u < 0 ? 0 : (u > 1 ? 1 : u);
+		v = v < 0 ? 0 : (v > 1 ? 1 : v);
+
+		double w[4];
+		w[0] = (1 - u) * (1 - v);
+		w[1] = u * (1 - v);
+		w[2] = (1 - u) * v;
+		w[3] = u * v;
+		double sum = 0;
+		double weights = 0;
+		for(n = 0; n < 4; n++) {
+			af_real val = souVal[corner[n]];
+			if(val >= 0 && w[n] > 0) {
+				sum += w[n] * val;
+				weights += w[n];
+			}
+		}
+		if(weights > 0) {
+			tarVal[i] = sum / weights;
+		}
+		else {
+			tarVal[i] = souVal[nnSouID] >= 0 ? souVal[nnSouID] : -999;
+		}
+	}
+}
+
+//FNV-1a over raw bytes, chained through the running hash
+static unsigned long long fnv1a(const void * data, size_t len, unsigned long long hash) {
+
+	const unsigned char * bytes = (const unsigned char *)data;
+	size_t i;
+	for(i = 0; i < len; i++) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+unsigned long long geoFingerprint(af_real * lat, af_real * lon, int n) {
+
+	unsigned long long hash = 14695981039346656037ULL;
+	hash = fnv1a(&n, sizeof(int), hash);
+	hash = fnv1a(lat, sizeof(af_real) * (n > 0 ? n : 0), hash);
+	hash = fnv1a(lon, sizeof(af_real) * (n > 0 ? n : 0), hash);
+	return hash;
+}
+
+unsigned long long nnMappingKey(af_real * souLat, af_real * souLon, int nSou, af_real * tarLat, af_real * tarLon, int nTar, double maxR) {
+
+	unsigned long long key[2];
+	key[0] = geoFingerprint(souLat, souLon, nSou);
+	key[1] = geoFingerprint(tarLat, tarLon, nTar);
+	unsigned long long hash = 14695981039346656037ULL;
+	hash = fnv1a(key, sizeof(key), hash);
+	hash = fnv1a(&maxR, sizeof(double), hash);
+	return hash;
+}
+
+#define TREE_LEAF 8
+
+struct sphereTree {
+	int n;
+	double * xyz;		//unit vectors of the sources in tree order, packed x, y, z
+	int * id;		//source ID of each point in tree order
+	unsigned char * splitDim;	//splitting axis of each internal node, stored at its median point
+	int * pos;		//tree order position of each source ID
+};
+
+static void toUnitVector(double lat, double lon, double * v) {
+
+	lat = lat * M_PI / 180;
+	lon = lon * M_PI / 180;
+	v[0] = cos(lat) * cos(lon);
+	v[1] = cos(lat) * sin(lon);
+	v[2] = sin(lat);
+}
+
+//Squared chord length of a great circle distance in meters
+static double squaredChord(double maxR) {
+
+	const double earthRadius = 6367444;
+	double chord = 2 * sin(maxR / earthRadius / 2);
+	return chord * chord;
+}
+
+static double chordToMeters(double d) {
+
+	const double earthRadius = 6367444;
+	return 2 * asin(sqrt(d) / 2) * earthRadius;
+}
+
+static void swapTreePoints(double * xyz, int * id, int a, int b) {
+
+	double t;
+	int c;
+	for(c = 0; c < 3; c++) {
+		t = xyz[3 * a + c];
+		xyz[3 * a + c] = xyz[3 * b + c];
+		xyz[3 * b + c] = t;
+	}
+	int tid = id[a];
+	id[a] = id[b];
+	id[b] = tid;
+}
+
+//Partially sorts [lo, hi) on axis dim so that the k-th point is in its sorted position
+static void selectTreePoint(double * xyz, int * id, int lo, int hi, int k, int dim) {
+
+	hi = hi - 1;
+	while(hi > lo) {
+		int mid = lo + (hi - lo) / 2;
+		//Median of three as the pivot, moved to hi
+		if(xyz[3 * mid + dim] < xyz[3 * lo + dim]) swapTreePoints(xyz, id, mid, lo);
+		if(xyz[3 * hi + dim] < xyz[3 * lo + dim]) swapTreePoints(xyz, id, hi, lo);
+		if(xyz[3 * mid + dim] < xyz[3 * hi + dim]) swapTreePoints(xyz, id, mid, hi);
+		double pivot = xyz[3 * hi + dim];
+
+		//Three way partition into < pivot, == pivot, > pivot so repeated coordinates stay linear
+		int less = lo;
+		int greater = hi;
+		int i = lo;
+		while(i <= greater) {
+			if(xyz[3 * i + dim] < pivot) {
+				swapTreePoints(xyz, id, i, less);
+				less ++;
+				i ++;
+			}
+			else if(xyz[3 * i + dim] > pivot) {
+				swapTreePoints(xyz, id, i, greater);
+				greater --;
+			}
+			else {
+				i ++;
+			}
+		}
+
+		if(k < less) {
+			hi = less - 1;
+		}
+		else if(k > greater) {
+			lo = greater + 1;
+		}
+		else {
+			return;
+		}
+	}
+}
+
+static void buildTree(sphereTree * tree, int lo, int hi) {
+
+	while(hi - lo > TREE_LEAF) {
+
+		//Split on the axis with the largest extent
+		double minV[3] = {2, 2, 2};
+		double maxV[3] = {-2, -2, -2};
+		int i, c;
+		for(i = lo; i < hi; i++) {
+			for(c = 0; c < 3; c++) {
+				double v = tree->xyz[3 * i + c];
+				minV[c] = v < minV[c] ? v : minV[c];
+				maxV[c] = v > maxV[c] ? v : maxV[c];
+			}
+		}
+		int dim = 0;
+		for(c = 1; c < 3; c++) {
+			if(maxV[c] - minV[c] > maxV[dim] - minV[dim]) {
+				dim = c;
+			}
+		}
+
+		int mid = lo + (hi - lo) / 2;
+		selectTreePoint(tree->xyz, tree->id, lo, hi, mid, dim);
+		tree->splitDim[mid] = dim;
+
+		//Large subtrees are built as OpenMP tasks; each owns a disjoint range of the point arrays
+		#pragma omp task if(mid - lo > 65536)
+		buildTree(tree, lo, mid);
+		lo = mid + 1;
+	}
+}
+
+sphereTree * sphereTreeCreate(af_real * souLat, af_real * souLon, int nSou) {
+
+	sphereTree * tree;
+	if(NULL == (tree = (sphereTree *)malloc(sizeof(sphereTree)))) {
+		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
+		exit(1);
+	}
+	tree->n = nSou;
+	if(NULL == (tree->xyz = (double *)malloc(sizeof(double) * 3 * (nSou > 0 ? nSou : 1)))) {
+		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
+		exit(1);
+	}
+	if(NULL == (tree->id = (int *)malloc(sizeof(int) * (nSou > 0 ? nSou : 1)))) {
+		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
+		exit(1);
+	}
+	if(NULL == (tree->splitDim = (unsigned char *)malloc(sizeof(unsigned char) * (nSou > 0 ? nSou : 1)))) {
+		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
+		exit(1);
+	}
+	if(NULL == (tree->pos = (int *)malloc(sizeof(int) * (nSou > 0 ? nSou : 1)))) {
+		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
+		exit(1);
+	}
+
+	int i;
+	#pragma omp parallel for schedule(static)
+	for(i = 0; i < nSou; i++) {
+		toUnitVector(souLat[i], souLon[i], &tree->xyz[3 * i]);
+		tree->id[i] = i;
+	}
+	#pragma omp parallel
+	#pragma omp single
+	buildTree(tree, 0, nSou);
+
+	#pragma omp parallel for schedule(static)
+	for(i = 0; i < nSou; i++) {
+		tree->pos[tree->id[i]] = i;
+	}
+
+	return tree;
+}
+
+void sphereTreeFree(sphereTree * tree) {
+
+	if(tree == NULL) {
+		return;
+	}
+	free(tree->xyz);
+	free(tree->id);
+	free(tree->splitDim);
+	free(tree->pos);
+	free(tree);
+}
+
+static double chordTo(const sphereTree * tree, int i, const double * q) {
+
+	double dx = tree->xyz[3 * i] - q[0];
+	double dy = tree->xyz[3 * i + 1] - q[1];
+	double dz = tree->xyz[3 * i + 2] - q[2];
+	return dx * dx + dy * dy + dz * dz;
+}
+
+//Candidates closer than *best, or as close with a smaller ID, replace the current answer
+static void nearestInTree(const sphereTree * tree, int lo, int hi, const double * q, double * best, int * bestID) {
+
+	while(hi > lo) {
+
+		if(hi - lo <= TREE_LEAF) {
+			int i;
+			for(i = lo; i < hi; i++) {
+				double d = chordTo(tree, i, q);
+				if(d < *best || (d == *best && (*bestID < 0 || tree->id[i] < *bestID))) {
+					*best = d;
+					*bestID = tree->id[i];
+				}
+			}
+			return;
+		}
+
+		int mid = lo + (hi - lo) / 2;
+		double d = chordTo(tree, mid, q);
+		if(d < *best || (d == *best && (*bestID < 0 || tree->id[mid] < *bestID))) {
+			*best = d;
+			*bestID = tree->id[mid];
+		}
+
+		int dim = tree->splitDim[mid];
+		double diff = q[dim] - tree->xyz[3 * mid + dim];
+		if(diff < 0) {
+			nearestInTree(tree, lo, mid, q, best, bestID);
+			if(diff * diff > *best) {
+				return;
+			}
+			lo = mid + 1;
+		}
+		else {
+			nearestInTree(tree, mid + 1, hi, q, best, bestID);
+			if(diff * diff > *best) {
+				return;
+			}
+			hi = mid;
+		}
+	}
+}
+
+int sphereTreeNearest(const sphereTree * tree, double tarLat, double tarLon, double maxR) {
+
+	double q[3];
+	toUnitVector(tarLat, tarLon, q);
+	double best = squaredChord(maxR);
+	int bestID = -1;
+	nearestInTree(tree, 0, tree->n, q, &best, &bestID);
+	return bestID;
+}
+
+void nearestNeighborOnTree(const sphereTree * tree, af_real * tarLat, af_real * tarLon, int * tarNNSouID, int nTar, double maxR) {
+
+	int i;
+	#pragma omp parallel for schedule(dynamic, 256)
+	for(i = 0; i < nTar; i++) {
+		tarNNSouID[i] = sphereTreeNearest(tree, tarLat[i], tarLon[i], maxR);
+	}
+}
+
+//True when every point outside the box is farther than the bound: splitting planes bound the
+//tree order range of a node, so nothing beyond them can still win or tie
+static int ballInBox(const double * boxLo, const double * boxHi, const double * q, double best) {
+
+	int c;
+	for(c = 0; c < 3; c++) {
+		double below = q[c] - boxLo[c];
+		double above = boxHi[c] - q[c];
+		if(below <= 0 || below * below <= best || above <= 0 || above * above <= best) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+//Nearest search started at the leaf holding a seed source whose squared chord is already in *best:
+//the leaf is searched first, then each ancestor's median point and other child only if the splitting
+//plane is within the current bound, stopping once the bound fits inside the node searched so far.
+//Gives the same answer as a search from the root.
+static void nearestFromSeed(const sphereTree * tree, int seedPos, const double * q, double * best, int * bestID) {
+
+	int pathLo[64];
+	int pathHi[64];
+	double boxLo[65][3];
+	double boxHi[65][3];
+	int depth = 0;
+	int lo = 0;
+	int hi = tree->n;
+	int c;
+	for(c = 0; c < 3; c++) {
+		boxLo[0][c] = -2;
+		boxHi[0][c] = 2;
+	}
+	while(hi - lo > TREE_LEAF) {
+		int mid = lo + (hi - lo) / 2;
+		if(seedPos == mid) {
+			break;
+		}
+		int dim = tree->splitDim[mid];
+		pathLo[depth] = lo;
+		pathHi[depth] = hi;
+		for(c = 0; c < 3; c++) {
+			boxLo[depth + 1][c] = boxLo[depth][c];
+			boxHi[depth + 1][c] = boxHi[depth][c];
+		}
+		if(seedPos < mid) {
+			hi = mid;
+			boxHi[depth + 1][dim] = tree->xyz[3 * mid + dim];
+		}
+		else {
+			lo = mid + 1;
+			boxLo[depth + 1][dim] = tree->xyz[3 * mid + dim];
+		}
+		depth ++;
+	}
+	nearestInTree(tree, lo, hi, q, best, bestID);
+
+	while(depth > 0 && !ballInBox(boxLo[depth], boxHi[depth], q, *best)) {
+		depth --;
+		int pLo = pathLo[depth];
+		int pHi = pathHi[depth];
+		int mid = pLo + (pHi - pLo) / 2;
+		int dim = tree->splitDim[mid];
+		double diff = q[dim] - tree->xyz[3 * mid + dim];
+
+		if(diff * diff <= *best) {
+			double d = chordTo(tree, mid, q);
+			if(d < *best || (d == *best && (*bestID < 0 || tree->id[mid] < *bestID))) {
+				*best = d;
+				*bestID = tree->id[mid];
+			}
+		}
+		//The other child lies on the far side of the plane unless the target is on its side
+		if(lo > mid) {
+			if(diff < 0 || diff * diff <= *best) {
+				nearestInTree(tree, pLo, mid, q, best, bestID);
+			}
+		}
+		else {
+			if(diff > 0 || diff * diff <= *best) {
+				nearestInTree(tree, mid + 1, pHi, q, best, bestID);
+			}
+		}
+		lo = pLo;
+		hi = pHi;
+	}
+}
+
+void nearestNeighborSwath(const sphereTree * tree, af_real * tarLat, af_real * tarLon, int * tarNNSouID, int nTar, double maxR) {
+
+	const int chunk = 4096;
+	double maxChord = squaredChord(maxR);
+	int start;
+	//Each thread walks whole runs of consecutive targets, so the warm start survives within a run
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(start = 0; start < nTar; start += chunk) {
+		int end = start + chunk < nTar ? start + chunk : nTar;
+		int seed = -1;
+		int i;
+		for(i = start; i < end; i++) {
+			double q[3];
+			toUnitVector(tarLat[i], tarLon[i], q);
+			double best = maxChord;
+			int bestID = -1;
+			if(seed >= 0) {
+				int seedPos = tree->pos[seed];
+				double d = chordTo(tree, seedPos, q);
+				if(d <= maxChord) {
+					best = d;
+					bestID = seed;
+					nearestFromSeed(tree, seedPos, q, &best, &bestID);
+				}
+				else {
+					nearestInTree(tree, 0, tree->n, q, &best, &bestID);
+				}
+			}
+			else {
+				nearestInTree(tree, 0, tree->n, q, &best, &bestID);
+			}
+			tarNNSouID[i] = bestID;
+			seed = bestID;
+		}
+	}
+}
+
+//k best so far as a max heap on (distance, ID)
+typedef struct {
+	int k;
+	int count;
+	double bound;
+	double * dis;
+	int * id;
+} treeHeap;
+
+static int heapAbove(treeHeap * heap, int a, int b) {
+
+	return heap->dis[a] > heap->dis[b] || (heap->dis[a] == heap->dis[b] && heap->id[a] > heap->id[b]);
+}
+
+static void heapSwap(treeHeap * heap, int a, int b) {
+
+	double td = heap->dis[a];
+	heap->dis[a] = heap->dis[b];
+	heap->dis[b] = td;
+	int tid = heap->id[a];
+	heap->id[a] = heap->id[b];
+	heap->id[b] = tid;
+}
+
+static void heapOffer(treeHeap * heap, double d, int id) {
+
+	if(d > heap->bound) {
+		return;
+	}
+	int i;
+	if(heap->count < heap->k) {
+		i = heap->count;
+		heap->count ++;
+		heap->dis[i] = d;
+		heap->id[i] = id;
+		while(i > 0 && heapAbove(heap, i, (i - 1) / 2)) {
+			heapSwap(heap, i, (i - 1) / 2);
+			i = (i - 1) / 2;
+		}
+	}
+	else {
+		if(d > heap->dis[0] || (d == heap->dis[0] && id > heap->id[0])) {
+			return;
+		}
+		heap->dis[0] = d;
+		heap->id[0] = id;
+		i = 0;
+		while(1) {
+			int largest = i;
+			int l = 2 * i + 1;
+			int r = 2 * i + 2;
+			if(l < heap->count && heapAbove(heap, l, largest)) largest = l;
+			if(r < heap->count && heapAbove(heap, r, largest)) largest = r;
+			if(largest == i) break;
+			heapSwap(heap, i, largest);
+			i = largest;
+		}
+	}
+	if(heap->count == heap->k) {
+		heap->bound = heap->dis[0];
+	}
+}
+
+static void kNearestInTree(const sphereTree * tree, int lo, int hi, const double * q, treeHeap * heap) {
+
+	while(hi > lo) {
+
+		if(hi - lo <= TREE_LEAF) {
+			int i;
+			for(i = lo; i < hi; i++) {
+				heapOffer(heap, chordTo(tree, i, q), tree->id[i]);
+			}
+			return;
+		}
+
+		int mid = lo + (hi - lo) / 2;
+		heapOffer(heap, chordTo(tree, mid, q), tree->id[mid]);
+
+		int dim = tree->splitDim[mid];
+		double diff = q[dim] - tree->xyz[3 * mid + dim];
+		if(diff < 0) {
+			kNearestInTree(tree, lo, mid, q, heap);
+			if(diff * diff > heap->bound) {
+				return;
+			}
+			lo = mid + 1;
+		}
+		else {
+			kNearestInTree(tree, mid + 1, hi, q, heap);
+			if(diff * diff > heap->bound) {
+				return;
+			}
+			hi = mid;
+		}
+	}
+}
+
+int sphereTreeKNearest(const sphereTree * tree, double tarLat, double tarLon, int k, double maxR, int * souID, double * souDis) {
+
+	if(k <= 0) {
+		return 0;
+	}
+	double q[3];
+	toUnitVector(tarLat, tarLon, q);
+
+	treeHeap heap;
+	heap.k = k;
+	heap.count = 0;
+	heap.bound = squaredChord(maxR);
+	heap.dis = souDis;
+	heap.id = souID;
+	kNearestInTree(tree, 0, tree->n, q, &heap);
+
+	//Heap sort in place to nearest first
+	int found = heap.count;
+	while(heap.count > 1) {
+		heapSwap(&heap, 0, heap.count - 1);
+		heap.count --;
+		int i = 0;
+		while(1) {
+			int largest = i;
+			int l = 2 * i + 1;
+			int r = 2 * i + 2;
+			if(l < heap.count && heapAbove(&heap, l, largest)) largest = l;
+			if(r < heap.count && heapAbove(&heap, r, largest)) largest = r;
+			if(largest == i) break;
+			heapSwap(&heap, i, largest);
+			i = largest;
+		}
+	}
+	int i;
+	for(i = 0; i < found; i++) {
+		souDis[i] = chordToMeters(souDis[i]);
+	}
+	return found;
+}
+
+void kNearestNeighborOnTree(const sphereTree * tree, af_real * tarLat, af_real * tarLon, int nTar, int k, double maxR, int * tarKNNSouID, double * tarKNNDis) {
+
+	int i;
+	#pragma omp parallel for schedule(dynamic, 256)
+	for(i = 0; i < nTar; i++) {
+		int * souID = tarKNNSouID + (size_t)i * k;
+		double * souDis = tarKNNDis + (size_t)i * k;
+		int found = sphereTreeKNearest(tree, tarLat[i], tarLon[i], k, maxR, souID, souDis);
+		int j;
+		for(j = found; j < k; j++) {
+			souID[j] = -1;
+			souDis[j] = -1;
+		}
+	}
+}
+
+typedef struct {
+	int count;
+	int capacity;
+	int * id;
+} treeList;
+
+static void radiusInTree(const sphereTree * tree, int lo, int hi, const double * q, double bound, treeList * list) {
+
+	while(hi > lo) {
+
+		int i;
+		if(hi - lo <= TREE_LEAF) {
+			for(i = lo; i < hi; i++) {
+				if(chordTo(tree, i, q) <= bound) {
+					if(list->count == list->capacity) {
+						list->capacity = list->capacity * 2;
+						if(NULL == (list->id = (int *)realloc(list->id, sizeof(int) * list->capacity))) {
+							printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
+							exit(1);
+						}
+					}
+					list->id[list->count ++] = tree->id[i];
+				}
+			}
+			return;
+		}
+
+		int mid = lo + (hi - lo) / 2;
+		radiusInTree(tree, mid, mid + 1, q, bound, list);
+
+		int dim = tree->splitDim[mid];
+		double diff = q[dim] - tree->xyz[3 * mid + dim];
+		if(diff < 0) {
+			radiusInTree(tree, lo, mid, q, bound, list);
+			if(diff * diff > bound) {
+				return;
+			}
+			lo = mid + 1;
+		}
+		else {
+			radiusInTree(tree, mid + 1, hi, q, bound, list);
+			if(diff * diff > bound) {
+				return;
+			}
+			hi = mid;
+		}
+	}
+}
+
+static int compareInt(const void * a, const void * b) {
+
+	int ia = *(const int *)a;
+	int ib = *(const int *)b;
+	return ia < ib ? -1 : (ia > ib);
+}
+
+int * sphereTreeRadius(const sphereTree * tree, double tarLat, double tarLon, double maxR, int * count) {
+
+	double q[3];
+	toUnitVector(tarLat, tarLon, q);
+
+	treeList list;
+	list.count = 0;
+	list.capacity = 16;
+	if(NULL == (list.id = (int *)malloc(sizeof(int) * list.capacity))) {
+		printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
+		exit(1);
+	}
+	radiusInTree(tree, 0, tree->n, q, squaredChord(maxR), &list);
+	qsort(list.id, list.count, sizeof(int), compareInt);
+
+	*count = list.count;
+	return list.id;
+}
+
+static inline void blockAverageRow(const af_real * souPlane, af_real * tarRow, double * sum, af_real * minVal, int row, int nCols, int nTarCols, int factor) {
+
+	int c;
+	for(c = 0; c < nTarCols; c++) {
+		sum[c] = 0.0;
+		minVal[c] = 0;
+	}
+
+	int a, b;
+	for(a = 0; a < factor; a++) {
+		const af_real * souRow = souPlane + (size_t)(row * factor + a) * nCols;
+		#pragma omp simd
+		for(c = 0; c < nTarCols; c++) {
+			double s = sum[c];
+			af_real m = minVal[c];
+			for(b = 0; b < factor; b++) {
+				af_real v = souRow[c * factor + b];
+				s += v;
+				m = v < m ? v : m;
+			}
+			sum[c] = s;
+			minVal[c] = m;
+		}
+	}
+
+	double count = factor * factor;
+	#pragma omp simd
+	for(c = 0; c < nTarCols; c++) {
+		tarRow[c] = minVal[c] < 0 ? -999 : sum[c] / count;
+	}
+}
+
+int blockAverage(af_real * souVal, af_real * tarVal, int nPlanes, int nRows, int nCols, int factor) {
+
+	if(factor != 2 && factor != 4 && factor != 8) {
+		printf("ERROR: Unsupported block averaging factor %d\n", factor);
+		return -1;
+	}
+
+	int nTarRows = nRows / factor;
+	int nTarCols = nCols / factor;
+	if(nPlanes <= 0 || nTarRows <= 0 || nTarCols <= 0) {
+		return 0;
+	}
+
+	#pragma omp parallel
+	{
+		double * sum;
+		af_real * minVal;
+		if(NULL == (sum = (double *)malloc(sizeof(double) * nTarCols))) {
+			printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
+			exit(1);
+		}
+		if(NULL == (minVal = (af_real *)malloc(sizeof(af_real) * nTarCols))) {
+			printf("ERROR: Out of memory at line %d in file %s\n", __LINE__, __FILE__);
+			exit(1);
+		}
+
+		int p, r;
+		#pragma omp for collapse(2) schedule(static)
+		for(p = 0; p < nPlanes; p++) {
+			for(r = 0; r < nTarRows; r++) {
+				const af_real * souPlane = souVal + (size_t)p * nRows * nCols;
+				af_real * tarRow = tarVal + ((size_t)p * nTarRows + r) * nTarCols;
+				//Constant factors let the compiler unroll the window loop
+				switch(factor) {
+					case 2: blockAverageRow(souPlane, tarRow, sum, minVal, r, nCols, nTarCols, 2); break;
+					case 4: blockAverageRow(souPlane, tarRow, sum, minVal, r, nCols, nTarCols, 4); break;
+					default: blockAverageRow(souPlane, tarRow, sum, minVal, r, nCols, nTarCols, 8); break;
+				}
+			}
+		}
+
+		free(sum);
+		free(minVal);
+	}
+
+	return 0;
 }
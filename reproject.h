@@ -7,50 +7,414 @@
 #ifndef REPROH
 #define REPROH
 
+/**
+ * af_real is the storage type of radiances and geolocation in the whole pipeline.
+ * It is double by default; building with -DAF_USE_FLOAT32 switches readers, kernels and
+ * writers to float to halve memory and bandwidth. Distances are always computed in double.
+ */
+#ifdef AF_USE_FLOAT32
+typedef float af_real;
+#else
+typedef double af_real;
+#endif
+
+/**
+ * nnWorkspace holds the search index built by "nearestNeighborConst" (sorted source IDs, unit vectors,
+ * band and cell tables and per thread scratch). Its buffers only grow, so a workspace reused across calls
+ * of similar size allocates nothing after the first call. A workspace must not be shared by concurrent calls.
+ */
+typedef struct nnWorkspace nnWorkspace;
+
+/**
+ * NAME:	nnWorkspaceCreate
+ * DESCRIPTION:	Create an empty search workspace, to be released with "nnWorkspaceFree"
+ */
+nnWorkspace * nnWorkspaceCreate();
+
+/**
+ * NAME:	nnWorkspaceFree
+ * DESCRIPTION:	Release a search workspace and all its buffers
+ */
+void nnWorkspaceFree(nnWorkspace * ws);
+
+/**
+ * NAME:	nearestNeighborConst
+ * DESCRIPTION:	Find the nearest neighboring source cell's ID for each target cell without changing any input
+ * PARAMETERS:
+ *	nnWorkspace * ws:	the workspace holding the search index and scratch buffers
+ *	const af_real * souLat:	the latitudes of source cells (degrees)
+ *	const af_real * souLon:	the longitudes of source cells (degrees)
+ *	int nSou:		the number of source cells
+ *	const af_real * tarLat:	the latitudes of target cells (degrees)
+ *	const af_real * tarLon:	the longitudes of target cells (degrees)
+ *	int * tarNNSouID:	the output IDs of nearest neighboring source cells 
+ *	int nTar:		the number of target cells
+ *	double maxR:		the maximum distance (in meters) to define neighboring cells
+ * Output: 	
+ *	int * tarNNSouID:	the output IDs of nearest neighboring source cells (-1 if none within maxR)
+ */ 
+void nearestNeighborConst(nnWorkspace * ws, const af_real * souLat, const af_real * souLon, int nSou, const af_real * tarLat, const af_real * tarLon, int * tarNNSouID, int nTar, double maxR);
+
 /**
  * NAME:	nearestNeighbor
- * DESCRIPTION:	Find the nearest neighboring source cell's ID for each target cell
+ * DESCRIPTION:	Find the nearest neighboring source cell's ID for each target cell, with a workspace of its own
+ *		(see "nearestNeighborConst"). The input arrays are not changed.
  * PARAMETERS:
- *	double ** psouLat:	the pointer to the array of latitudes of source cells (the data are changed during in the function, so please do the output before this function)
- *	double ** psouLon:	the pointer to the array of longitudes of source cells (the data are changed during in the function, so please do the output before this function)
+ *	af_real ** psouLat:	the pointer to the array of latitudes of source cells
+ *	af_real ** psouLon:	the pointer to the array of longitudes of source cells
  *	int nSou:		the number of source cells
- *	double * tarLat:	the latitudes of target cells
- *	double * tarLon:	the longitudes of target cells
+ *	af_real * tarLat:	the latitudes of target cells
+ *	af_real * tarLon:	the longitudes of target cells
  *	int * tarNNSouID:	the output IDs of nearest neighboring source cells 
  *	int nTar:		the number of target cells
  *	double maxR:		the maximum distance (in meters) to define neighboring cells
  * Output: 	
  *	int * tarNNSouID:	the output IDs of nearest neighboring source cells 
  */ 
-void nearestNeighbor(double ** psouLat, double ** psouLon, int nSou, double * tarLat, double * tarLon, int * tarNNSouID, int nTar, double maxR);
+void nearestNeighbor(af_real ** psouLat, af_real ** psouLon, int nSou, af_real * tarLat, af_real * tarLon, int * tarNNSouID, int nTar, double maxR);
 
 /**
  * NAME:	nnInterpolate
  * DESCRIPTION:	Nearest neighbor interpolation
  * PARAMETERS:
- * 	double * souVal:	the input values at source cells
- * 	double * tarVal:	the output values at target cells
+ * 	af_real * souVal:	the input values at source cells
+ * 	af_real * tarVal:	the output values at target cells
  * 	int * tarNNSouID:	the IDs of nearest neighboring source cells for each target cells (generated from "nearestNeighbor") 
  *	int nTar:		the number of target cells
  * Output: 	
- * 	double * tarVal:	the output values at target cells
+ * 	af_real * tarVal:	the output values at target cells
  */ 
-void nnInterpolate(double * souVal, double * tarVal, int * tarNNSouID, int nTar);
+void nnInterpolate(af_real * souVal, af_real * tarVal, int * tarNNSouID, int nTar);
 
 /**
  * NAME:	summaryInterpolate
- * DESCRIPTION:	Interpolation (summary) from fine resolution to coarse resolution
+ * DESCRIPTION:	Interpolation (summary) from fine resolution to coarse resolution. Runs in parallel over targets;
+ *		each target sums its sources in source order, so results do not depend on the number of threads
  * PARAMETERS:
- * 	double * souVal:	the input values at source cells
- * 	int * souNNTarID:	the IDs of nearest neighboring target cells for each source cells (generated from "nearestNeighbor")
+ * 	af_real * souVal:	the input values at source cells
+ * 	int * souNNTarID:	the IDs of nearest neighboring target cells for each source cells (generated from "nearestNeighbor");
+ *				0 is the first target, a negative ID marks a source without a target
  * 	int nSou:		the number of source cells
- * 	double * tarVal:	the output values at target cells
+ * 	af_real * tarVal:	the output values at target cells
  * 	int * nSouPixels:	the output numbers of contributing source cells to each target cell
  *	int nTar:		the number of target cells
  * Output:
- * 	double * tarVal:	the output values at target cells
+ * 	af_real * tarVal:	the output values at target cells
  * 	int * nSouPixels:	the output numbers of contributing source cells to each target cell
  */
-void summaryInterpolate(double * souVal, int * souNNTarID, int nSou, double * tarVal, int * nSouPixels, int nTar);
+void summaryInterpolate(af_real * souVal, int * souNNTarID, int nSou, af_real * tarVal, int * nSouPixels, int nTar);
+
+/**
+ * NAME:	nnInterpolateBands
+ * DESCRIPTION:	Nearest neighbor interpolation of several bands sharing one mapping, in a single pass over
+ *		the mapping. Output is band-interleaved: band b of target i is tarVal[i * nBands + b]
+ * PARAMETERS:
+ * 	af_real ** souVals:	the input values at source cells, one array per band
+ *	int nBands:		the number of bands
+ * 	af_real * tarVal:	the output values at target cells (nTar * nBands)
+ * 	int * tarNNSouID:	the IDs of nearest neighboring source cells for each target cells (generated from "nearestNeighbor")
+ *	int nTar:		the number of target cells
+ * Output:
+ * 	af_real * tarVal:	the output values at target cells
+ */
+void nnInterpolateBands(af_real ** souVals, int nBands, af_real * tarVal, int * tarNNSouID, int nTar);
+
+/**
+ * NAME:	nnInterpolateCube
+ * DESCRIPTION:	Same as "nnInterpolateBands" for band-interleaved source values (band b of source j is
+ *		souCube[j * nBands + b]), so each target copies one contiguous row
+ * PARAMETERS:
+ * 	af_real * souCube:	the input values at source cells (nSou * nBands)
+ *	int nBands:		the number of bands
+ * 	af_real * tarVal:	the output values at target cells (nTar * nBands)
+ * 	int * tarNNSouID:	the IDs of nearest neighboring source cells for each target cells (generated from "nearestNeighbor")
+ *	int nTar:		the number of target cells
+ * Output:
+ * 	af_real * tarVal:	the output values at target cells
+ */
+void nnInterpolateCube(af_real * souCube, int nBands, af_real * tarVal, int * tarNNSouID, int nTar);
+
+/**
+ * NAME:	summaryInterpolateBands
+ * DESCRIPTION:	"summaryInterpolate" of several bands sharing one mapping, in a single pass over the mapping.
+ *		Output is band-interleaved: band b of target i is tarVal[i * nBands + b]
+ * PARAMETERS:
+ * 	af_real ** souVals:	the input values at source cells, one array per band
+ *	int nBands:		the number of bands
+ * 	int * souNNTarID:	the IDs of nearest neighboring target cells for each source cells (generated from "nearestNeighbor");
+ *				0 is the first target, a negative ID marks a source without a target
+ * 	int nSou:		the number of source cells
+ * 	af_real * tarVal:	the output values at target cells (nTar * nBands)
+ * 	int * nSouPixels:	the output numbers of contributing source cells to each target cell and band (nTar * nBands)
+ *	int nTar:		the number of target cells
+ * Output:
+ * 	af_real * tarVal:	the output values at target cells
+ * 	int * nSouPixels:	the output numbers of contributing source cells to each target cell and band
+ */
+void summaryInterpolateBands(af_real ** souVals, int nBands, int * souNNTarID, int nSou, af_real * tarVal, int * nSouPixels, int nTar);
+
+/**
+ * summaryStats holds per target statistics of the contributing source values as separate arrays
+ * (structure of arrays), each of nTar entries. std is the population standard deviation. Targets
+ * without valid sources have count 0 and -999 in every other field.
+ */
+typedef struct {
+	int nTar;
+	af_real * mean;
+	af_real * std;
+	af_real * min;
+	af_real * max;
+	int * count;
+} summaryStats;
+
+/**
+ * NAME:	summaryStatsCreate
+ * DESCRIPTION:	Allocate the statistics arrays of nTar target cells, to be released with "summaryStatsFree"
+ * PARAMETERS:
+ *	int nTar:		the number of target cells
+ * Return:	the statistics
+ */
+summaryStats * summaryStatsCreate(int nTar);
+
+/**
+ * NAME:	summaryStatsFree
+ * DESCRIPTION:	Release statistics created by "summaryStatsCreate"
+ * PARAMETERS:
+ *	summaryStats * stats:	the statistics (may be NULL)
+ */
+void summaryStatsFree(summaryStats * stats);
+
+/**
+ * NAME:	summaryInterpolateStats
+ * DESCRIPTION:	"summaryInterpolate" computing mean, standard deviation (Welford), min, max and count of the valid
+ *		(non negative) source values of each target in one pass over the sources. count equals the output of
+ *		"summaryInterpolate" and mean matches it up to rounding. Results do not depend on the number of threads
+ * PARAMETERS:
+ * 	af_real * souVal:	the input values at source cells
+ * 	int * souNNTarID:	the IDs of nearest neighboring target cells for each source cells (generated from "nearestNeighbor");
+ *				0 is the first target, a negative ID marks a source without a target
+ * 	int nSou:		the number of source cells
+ *	summaryStats * stats:	the output statistics, created for the nTar target cells
+ * Output:
+ *	summaryStats * stats:	the output statistics of each target cell
+ */
+void summaryInterpolateStats(af_real * souVal, int * souNNTarID, int nSou, summaryStats * stats);
+
+/**
+ * NAME:	idwInterpolate
+ * DESCRIPTION:	Inverse distance weighted interpolation over the k nearest source cells. Negative (fill)
+ *		source values are left out; a source at distance 0 gives its value directly
+ * PARAMETERS:
+ * 	af_real * souVal:	the input values at source cells
+ * 	af_real * tarVal:	the output values at target cells
+ *	int * tarKNNSouID:	the IDs of the k nearest source cells of each target (generated from "kNearestNeighborOnTree")
+ *	double * tarKNNDis:	their distances in meters
+ *	int nTar:		the number of target cells
+ *	int k:			the number of neighbors per target
+ *	double power:		the power of the distance in the weights (2 is the usual choice)
+ * Output:
+ * 	af_real * tarVal:	the output values at target cells (-999 without valid neighbors)
+ */
+void idwInterpolate(af_real * souVal, af_real * tarVal, int * tarKNNSouID, double * tarKNNDis, int nTar, int k, double power);
+
+/**
+ * NAME:	bilinearInterpolate
+ * DESCRIPTION:	Bilinear interpolation from a source swath stored as a row-major grid (nRows x nCols cells).
+ *		The nearest source cell of each target picks the grid quad around the target, and the target's
+ *		position in the quad comes from the local geometry on the unit sphere. Negative (fill) corners
+ *		are left out and the remaining weights renormalized; with no valid corner the nearest value is used
+ * PARAMETERS:
+ *	af_real * souLat:	the latitudes of source cells (degrees)
+ *	af_real * souLon:	the longitudes of source cells (degrees)
+ * 	af_real * souVal:	the input values at source cells
+ *	int nRows:		the number of rows of the source grid
+ *	int nCols:		the number of columns of the source grid
+ *	af_real * tarLat:	the latitudes of target cells (degrees)
+ *	af_real * tarLon:	the longitudes of target cells (degrees)
+ * 	int * tarNNSouID:	the IDs of nearest neighboring source cells for each target cells (generated from "nearestNeighbor")
+ * 	af_real * tarVal:	the output values at target cells
+ *	int nTar:		the number of target cells
+ * Output:
+ * 	af_real * tarVal:	the output values at target cells (-999 without a valid nearest source or corner)
+ */
+void bilinearInterpolate(af_real * souLat, af_real * souLon, af_real * souVal, int nRows, int nCols, af_real * tarLat, af_real * tarLon, int * tarNNSouID, af_real * tarVal, int nTar);
+
+/**
+ * NAME:	geoFingerprint
+ * DESCRIPTION:	64-bit FNV-1a hash of a geolocation set (count, latitudes and longitudes as stored)
+ * PARAMETERS:
+ *	af_real * lat:		the latitudes of the cells
+ *	af_real * lon:		the longitudes of the cells
+ *	int n:			the number of cells
+ * Return:	the fingerprint
+ */
+unsigned long long geoFingerprint(af_real * lat, af_real * lon, int n);
+
+/**
+ * NAME:	nnMappingKey
+ * DESCRIPTION:	Key of a nearest neighbor mapping, combining the fingerprints of both geolocation sets and the radius
+ * PARAMETERS:
+ *	af_real * souLat, af_real * souLon, int nSou:	the source cells
+ *	af_real * tarLat, af_real * tarLon, int nTar:	the target cells
+ *	double maxR:		the maximum distance (in meters) to define neighboring cells
+ * Return:	the key
+ */
+unsigned long long nnMappingKey(af_real * souLat, af_real * souLon, int nSou, af_real * tarLat, af_real * tarLon, int nTar, double maxR);
+
+/**
+ * sphereTree is a k-d tree over the unit vectors of a set of source cells. It is built once and
+ * can then serve any number of target sets (e.g. one MISR geolocation for MODIS, CERES and ASTER).
+ * Unlike the latitude bands of "nearestNeighbor" it stays balanced near the poles and with very uneven
+ * source density. Queries do not modify the tree, so they may run concurrently.
+ * Distances are great circle distances in meters; ties are resolved to the smaller source ID.
+ */
+typedef struct sphereTree sphereTree;
+
+/**
+ * NAME:	sphereTreeCreate
+ * DESCRIPTION:	Build a spatial index over source cells
+ * PARAMETERS:
+ *	af_real * souLat:	the latitudes of source cells (degrees, not modified)
+ *	af_real * souLon:	the longitudes of source cells (degrees, not modified)
+ *	int nSou:		the number of source cells
+ * Return:	the index, to be released with "sphereTreeFree"
+ */
+sphereTree * sphereTreeCreate(af_real * souLat, af_real * souLon, int nSou);
+
+/**
+ * NAME:	sphereTreeFree
+ * DESCRIPTION:	Release a spatial index created by "sphereTreeCreate"
+ */
+void sphereTreeFree(sphereTree * tree);
+
+/**
+ * NAME:	sphereTreeNearest
+ * DESCRIPTION:	Find the nearest source cell to one target location
+ * PARAMETERS:
+ *	const sphereTree * tree:	the spatial index of source cells
+ *	double tarLat:		the latitude of the target (degrees)
+ *	double tarLon:		the longitude of the target (degrees)
+ *	double maxR:		the maximum distance (in meters) to define neighboring cells
+ * Return:	the ID of the nearest source cell, or -1 if none is within maxR
+ */
+int sphereTreeNearest(const sphereTree * tree, double tarLat, double tarLon, double maxR);
+
+/**
+ * NAME:	nearestNeighborOnTree
+ * DESCRIPTION:	Find the nearest neighboring source cell's ID for each target cell using a prebuilt index
+ * PARAMETERS:
+ *	const sphereTree * tree:	the spatial index of source cells
+ *	af_real * tarLat:	the latitudes of target cells (degrees, not modified)
+ *	af_real * tarLon:	the longitudes of target cells (degrees, not modified)
+ *	int * tarNNSouID:	the output IDs of nearest neighboring source cells
+ *	int nTar:		the number of target cells
+ *	double maxR:		the maximum distance (in meters) to define neighboring cells
+ * Output:
+ *	int * tarNNSouID:	the output IDs of nearest neighboring source cells (-1 if none within maxR)
+ */
+void nearestNeighborOnTree(const sphereTree * tree, af_real * tarLat, af_real * tarLon, int * tarNNSouID, int nTar, double maxR);
+
+/**
+ * NAME:	nearestNeighborSwath
+ * DESCRIPTION:	Same result as "nearestNeighborOnTree" for targets stored in scan order (MODIS/MISR swaths).
+ *		Each query is seeded with the previous target's answer: its distance bounds the search, which
+ *		starts at the seed's leaf and only widens where the bound reaches. Targets without a usable seed
+ *		(first of a run, or previous answer out of range) fall back to the search from the root.
+ * PARAMETERS:
+ *	const sphereTree * tree:	the spatial index of source cells
+ *	af_real * tarLat:	the latitudes of target cells (degrees, not modified)
+ *	af_real * tarLon:	the longitudes of target cells (degrees, not modified)
+ *	int * tarNNSouID:	the output IDs of nearest neighboring source cells
+ *	int nTar:		the number of target cells
+ *	double maxR:		the maximum distance (in meters) to define neighboring cells
+ * Output:
+ *	int * tarNNSouID:	the output IDs of nearest neighboring source cells (-1 if none within maxR)
+ */
+void nearestNeighborSwath(const sphereTree * tree, af_real * tarLat, af_real * tarLon, int * tarNNSouID, int nTar, double maxR);
+
+/**
+ * NAME:	sphereTreeKNearest
+ * DESCRIPTION:	Find the k nearest source cells to one target location
+ * PARAMETERS:
+ *	const sphereTree * tree:	the spatial index of source cells
+ *	double tarLat:		the latitude of the target (degrees)
+ *	double tarLon:		the longitude of the target (degrees)
+ *	int k:			the number of neighbors wanted
+ *	double maxR:		the maximum distance (in meters) to define neighboring cells
+ *	int * souID:		the output IDs of the neighbors, room for k
+ *	double * souDis:	the output distances (in meters) of the neighbors, room for k
+ * Output:
+ *	int * souID, double * souDis:	the neighbors, nearest first
+ * Return:	the number of neighbors found (at most k)
+ */
+int sphereTreeKNearest(const sphereTree * tree, double tarLat, double tarLon, int k, double maxR, int * souID, double * souDis);
+
+/**
+ * NAME:	kNearestNeighborOnTree
+ * DESCRIPTION:	"sphereTreeKNearest" for every target cell, in parallel
+ * PARAMETERS:
+ *	const sphereTree * tree:	the spatial index of source cells
+ *	af_real * tarLat:	the latitudes of target cells (degrees, not modified)
+ *	af_real * tarLon:	the longitudes of target cells (degrees, not modified)
+ *	int nTar:		the number of target cells
+ *	int k:			the number of neighbors wanted per target
+ *	double maxR:		the maximum distance (in meters) to define neighboring cells
+ *	int * tarKNNSouID:	the output IDs of the neighbors, k per target (nTar * k)
+ *	double * tarKNNDis:	the output distances (in meters) of the neighbors, k per target (nTar * k)
+ * Output:
+ *	int * tarKNNSouID, double * tarKNNDis:	the neighbors of target i at [i * k, i * k + k), nearest first;
+ *				slots beyond the neighbors found hold ID -1 and distance -1
+ */
+void kNearestNeighborOnTree(const sphereTree * tree, af_real * tarLat, af_real * tarLon, int nTar, int k, double maxR, int * tarKNNSouID, double * tarKNNDis);
+
+/**
+ * NAME:	sphereTreeRadius
+ * DESCRIPTION:	Find all source cells within a distance of one target location
+ * PARAMETERS:
+ *	const sphereTree * tree:	the spatial index of source cells
+ *	double tarLat:		the latitude of the target (degrees)
+ *	double tarLon:		the longitude of the target (degrees)
+ *	double maxR:		the search radius (in meters)
+ *	int * count:		the output number of source cells found
+ * Return:	the IDs of the source cells in ascending order (to be freed by the caller)
+ */
+int * sphereTreeRadius(const sphereTree * tree, double tarLat, double tarLon, double maxR, int * count);
+
+/**
+ * NAME:	blockAverage
+ * DESCRIPTION:	Downsample a stack of 2-D grids by averaging non-overlapping factor x factor windows,
+ *		e.g. MISR 275m to 1.1km (factor 4, one plane per block) or MODIS 250m to 500m/1km (factor 2/4).
+ *		A window containing any negative (fill) value becomes -999. Planes and output rows are split across OpenMP threads.
+ * PARAMETERS:
+ * 	af_real * souVal:	the input values, nPlanes x nRows x nCols in row-major order
+ * 	af_real * tarVal:	the output values, nPlanes x (nRows/factor) x (nCols/factor); must not overlap souVal
+ *	int nPlanes:		the number of planes (e.g. MISR blocks)
+ *	int nRows:		the number of rows of each input plane
+ *	int nCols:		the number of columns of each input plane
+ *	int factor:		the window size, 2, 4 or 8; trailing rows/columns that do not fill a window are dropped
+ * Output:
+ * 	af_real * tarVal:	the output values
+ * Return:	0 on success, -1 for an unsupported factor
+ */
+int blockAverage(af_real * souVal, af_real * tarVal, int nPlanes, int nRows, int nCols, int factor);
+
+#ifdef AF_BENCH_STATS
+/**
+ * nnCandidateCount is the number of source cells "nearestNeighborConst" has compared with targets since it was
+ * last set to 0. Only builds with -DAF_BENCH_STATS (make bench) keep it, so the kernels pay nothing otherwise.
+ */
+extern long long nnCandidateCount;
+
+/**
+ * NAME:	nnBenchIndexOnLat
+ * DESCRIPTION:	Run only the latitude band sort of sources that "nearestNeighborConst" starts with, for timing
+ * PARAMETERS:
+ *	nnWorkspace * ws:	the workspace receiving the index
+ *	const af_real * souLat:	the latitudes of source cells (degrees)
+ *	int nSou:		the number of source cells
+ *	double maxR:		the search radius (in meters) the bands are sized for
+ */
+void nnBenchIndexOnLat(nnWorkspace * ws, const af_real * souLat, int nSou, double maxR);
+#endif
 
 #endif
@@ -213,20 +213,16 @@ int main(int argc, char ** argv) {
 */
 
 
-	double *iLat, *iLon, *oLat, *oLon, *iVal, *oVal;
-	double **piLat, **piLon;
+	af_real *iLat, *iLon, *oLat, *oLon, *iVal, *oVal;
 	int *tarNNSouID;
-	iLat=(double *)malloc(sizeof(double) * nIn);
-	iLon=(double *)malloc(sizeof(double) * nIn);
-	iVal=(double *)malloc(sizeof(double) * nIn);
+	iLat=(af_real *)malloc(sizeof(af_real) * nIn);
+	iLon=(af_real *)malloc(sizeof(af_real) * nIn);
+	iVal=(af_real *)malloc(sizeof(af_real) * nIn);
 
-	piLat = &iLat;
-	piLon = &iLon;
 
-
-	oLat=(double *)malloc(sizeof(double) * nOut);
-	oLon=(double *)malloc(sizeof(double) * nOut);
-	oVal=(double *)malloc(sizeof(double) * nOut);
+	oLat=(af_real *)malloc(sizeof(af_real) * nOut);
+	oLon=(af_real *)malloc(sizeof(af_real) * nOut);
+	oVal=(af_real *)malloc(sizeof(af_real) * nOut);
 	tarNNSouID=(int *)malloc(sizeof(int) * nOut);
 
 
@@ -241,7 +237,9 @@ int main(int argc, char ** argv) {
 		oLon[i] = outLon[i];
 	}
 
-	nearestNeighbor(piLat, piLon, nIn, oLat, oLon, tarNNSouID, nOut, maxR);
+	nnWorkspace * ws = nnWorkspaceCreate();
+	nearestNeighborConst(ws, iLat, iLon, nIn, oLat, oLon, tarNNSouID, nOut, maxR);
+	nnWorkspaceFree(ws);
 
 	nnInterpolate(iVal, oVal, tarNNSouID, nOut);
 
@@ -258,8 +256,8 @@ int main(int argc, char ** argv) {
 //		printf("%lf,%lf,%d\n", outLat[i], outLon[i], tarNNSouID[i]);
 	}
 
-	free(*piLat);
-	free(*piLon);
+	free(iLat);
+	free(iLon);
 	free(iVal);
 	free(oLat);
 	free(oLon);
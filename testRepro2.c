@@ -10,30 +10,29 @@
 #include <sys/time.h>
 #include "reproject.h"
 
+static af_real readValue(FILE * f) {
+	double v;
+	fscanf(f, "%lf,\n", &v);
+	return v;
+}
+
 int main(int argc, char ** argv) {
 
-	double * MODISLat, * MODISLon, * MODISVal;
-	double * MISRLat, * MISRLon, * MISRVal;
-	double ** pMODISLat, ** pMODISLon;
-	double ** pMISRLat, ** pMISRLon;
+	af_real * MODISLat, * MODISLon, * MODISVal;
+	af_real * MISRLat, * MISRLon, * MISRVal;
 	int * tarNNSouID;
 	int nMODIS = 1347102;
 	int nMISR = 262144;
 
 	double maxR = 1000;
 
-	MODISLat = (double *) malloc(sizeof(double) * nMODIS);
-	MODISLon = (double *) malloc(sizeof(double) * nMODIS);
-	MODISVal = (double *) malloc(sizeof(double) * nMODIS);
+	MODISLat = (af_real *) malloc(sizeof(af_real) * nMODIS);
+	MODISLon = (af_real *) malloc(sizeof(af_real) * nMODIS);
+	MODISVal = (af_real *) malloc(sizeof(af_real) * nMODIS);
 
-	MISRLat = (double *) malloc(sizeof(double) * nMISR);
-	MISRLon = (double *) malloc(sizeof(double) * nMISR);
-	MISRVal = (double *) malloc(sizeof(double) * nMISR);
-
-	pMODISLat = &MODISLat;
-	pMODISLon = &MODISLon;
-	pMISRLat = &MISRLat;
-	pMISRLon = &MISRLon;
+	MISRLat = (af_real *) malloc(sizeof(af_real) * nMISR);
+	MISRLon = (af_real *) malloc(sizeof(af_real) * nMISR);
+	MISRVal = (af_real *) malloc(sizeof(af_real) * nMISR);
 
 	FILE * fLat;
 	FILE * fLon;
@@ -45,9 +44,9 @@ int main(int argc, char ** argv) {
 
 	for(int i = 0; i < nMODIS; i++) {
 		
-		fscanf(fLat, "%lf,\n", MODISLat + i);
-		fscanf(fLon, "%lf,\n", MODISLon + i);
-		fscanf(fVal, "%lf,\n", MODISVal + i);
+		MODISLat[i] = readValue(fLat);
+		MODISLon[i] = readValue(fLon);
+		MODISVal[i] = readValue(fVal);
 	}
 
 
@@ -61,9 +60,9 @@ int main(int argc, char ** argv) {
 
 	for(int i = 0; i < nMISR; i++) {
 		
-		fscanf(fLat, "%lf,\n", MISRLat + i);
-		fscanf(fLon, "%lf,\n", MISRLon + i);
-		fscanf(fVal, "%lf,\n", MISRVal + i);
+		MISRLat[i] = readValue(fLat);
+		MISRLon[i] = readValue(fLon);
+		MISRVal[i] = readValue(fVal);
 	}
 
 
@@ -79,25 +78,12 @@ int main(int argc, char ** argv) {
 	}
 
 	tarNNSouID = (int *) malloc(sizeof(int) * nMODIS);
+	nnWorkspace * ws = nnWorkspaceCreate();
 	
-	nearestNeighbor(pMISRLat, pMISRLon, nMISR, MODISLat, MODISLon, tarNNSouID, nMODIS, maxR);
+	nearestNeighborConst(ws, MISRLat, MISRLon, nMISR, MODISLat, MODISLon, tarNNSouID, nMODIS, maxR);
 
 	nnInterpolate(MISRVal, MODISVal, tarNNSouID, nMODIS);
 
-
-	fLat = fopen("data/MODIS_Latitude-sub", "r");
-	fLon = fopen("data/MODIS_Longitude-sub", "r");
-
-	for(int i = 0; i < nMODIS; i++) {
-		
-		fscanf(fLat, "%lf,\n", MODISLat + i);
-		fscanf(fLon, "%lf,\n", MODISLon + i);
-	}
-
-
-	fclose(fLat);
-	fclose(fLon);
-
 	printf("Lat,Lon,Val\n");
 	for(int i = 0; i < nMODIS; i++) {
 		printf("%lf,%lf,%lf\n", MODISLat[i], MODISLon[i], MODISVal[i]);
@@ -112,24 +98,10 @@ int main(int argc, char ** argv) {
 
 	tarNNSouID = (int *) malloc(sizeof(int) * nMISR);
 	
-	nearestNeighbor(pMODISLat, pMODISLon, nMODIS, MISRLat, MISRLon, tarNNSouID, nMISR, maxR);
+	nearestNeighborConst(ws, MODISLat, MODISLon, nMODIS, MISRLat, MISRLon, tarNNSouID, nMISR, maxR);
 
 	nnInterpolate(MODISVal, MISRVal, tarNNSouID, nMISR);
 
-
-	fLat = fopen("data/MISR_Latitude-sub", "r");
-	fLon = fopen("data/MISR_Longitude-sub", "r");
-
-	for(int i = 0; i < nMISR; i++) {
-		
-		fscanf(fLat, "%lf,\n", MISRLat + i);
-		fscanf(fLon, "%lf,\n", MISRLon + i);
-	}
-
-
-	fclose(fLat);
-	fclose(fLon);
-
 	printf("Lat,Lon,Val\n");
 	for(int i = 0; i < nMISR; i++) {
 		printf("%lf,%lf,%lf\n", MISRLat[i], MISRLon[i], MISRVal[i]);
@@ -139,11 +111,12 @@ int main(int argc, char ** argv) {
 	//MODIS to MISR
 	
 
-	free(*pMODISLat);
-	free(*pMODISLon);
+	nnWorkspaceFree(ws);
+	free(MODISLat);
+	free(MODISLon);
 	free(MODISVal);
-	free(*pMISRLat);
-	free(*pMISRLon);
+	free(MISRLat);
+	free(MISRLon);
 	free(MISRVal);
 	free(tarNNSouID);
 
@@ -10,30 +10,29 @@
 #include <sys/time.h>
 #include "reproject.h"
 
+static af_real readValue(FILE * f) {
+	double v;
+	fscanf(f, "%lf,\n", &v);
+	return v;
+}
+
 int main(int argc, char ** argv) {
 
-	double * MODISLat, * MODISLon, * MODISVal;
-	double * MISRLat, * MISRLon, * MISRVal;
-	double ** pMODISLat, ** pMODISLon;
-	double ** pMISRLat, ** pMISRLon;
+	af_real * MODISLat, * MODISLon, * MODISVal;
+	af_real * MISRLat, * MISRLon, * MISRVal;
 	int * souNNTarID;
 	int nMODIS = 1347102;
 	int nMISR = 262144;
 
 	double maxR = 1000;
 
-	MODISLat = (double *) malloc(sizeof(double) * nMODIS);
-	MODISLon = (double *) malloc(sizeof(double) * nMODIS);
-	MODISVal = (double *) malloc(sizeof(double) * nMODIS);
+	MODISLat = (af_real *) malloc(sizeof(af_real) * nMODIS);
+	MODISLon = (af_real *) malloc(sizeof(af_real) * nMODIS);
+	MODISVal = (af_real *) malloc(sizeof(af_real) * nMODIS);
 
-	MISRLat = (double *) malloc(sizeof(double) * nMISR);
-	MISRLon = (double *) malloc(sizeof(double) * nMISR);
-	MISRVal = (double *) malloc(sizeof(double) * nMISR);
-	
-	pMODISLat = &MODISLat;
-	pMODISLon = &MODISLon;
-	pMISRLat = &MISRLat;
-	pMISRLon = &MISRLon;
+	MISRLat = (af_real *) malloc(sizeof(af_real) * nMISR);
+	MISRLon = (af_real *) malloc(sizeof(af_real) * nMISR);
+	MISRVal = (af_real *) malloc(sizeof(af_real) * nMISR);
 	
 	FILE * fLat;
 	FILE * fLon;
@@ -45,9 +44,9 @@ int main(int argc, char ** argv) {
 
 	for(int i = 0; i < nMODIS; i++) {
 		
-		fscanf(fLat, "%lf,\n", MODISLat + i);
-		fscanf(fLon, "%lf,\n", MODISLon + i);
-		fscanf(fVal, "%lf,\n", MODISVal + i);
+		MODISLat[i] = readValue(fLat);
+		MODISLon[i] = readValue(fLon);
+		MODISVal[i] = readValue(fVal);
 	}
 
 
@@ -61,9 +60,9 @@ int main(int argc, char ** argv) {
 
 	for(int i = 0; i < nMISR; i++) {
 		
-		fscanf(fLat, "%lf,\n", MISRLat + i);
-		fscanf(fLon, "%lf,\n", MISRLon + i);
-		fscanf(fVal, "%lf,\n", MISRVal + i);
+		MISRLat[i] = readValue(fLat);
+		MISRLon[i] = readValue(fLon);
+		MISRVal[i] = readValue(fVal);
 	}
 
 
@@ -71,6 +70,8 @@ int main(int argc, char ** argv) {
 	fclose(fLon);
 	fclose(fVal);
 
+	nnWorkspace * ws = nnWorkspaceCreate();
+
 	//MISR to MODIS
 /*	
 	printf("Lat,Lon,Val\n");
@@ -80,28 +81,12 @@ int main(int argc, char ** argv) {
 
 	souNNTarID = (int *) malloc(sizeof(int) * nMISR);
 	
-	nearestNeighbor(pMODISLat, pMODISLon, nMODIS, MISRLat, MISRLon, souNNTarID, nMISR, maxR);
-	
-	MODISLat = *pMODISLat;
-	MODISLon = *pMODISLon;
+	nearestNeighborConst(ws, MODISLat, MODISLon, nMODIS, MISRLat, MISRLon, souNNTarID, nMISR, maxR);
 
 	int * nMISRPixels = (int *) malloc(sizeof(int) * nMODIS);
 
 	summaryInterpolate(MISRVal, souNNTarID, nMISR, MODISVal, nMISRPixels, nMODIS);
 
-	fLat = fopen("data/MODIS_Latitude-sub", "r");
-	fLon = fopen("data/MODIS_Longitude-sub", "r");
-
-	for(int i = 0; i < nMODIS; i++) {
-		
-		fscanf(fLat, "%lf,\n", MODISLat + i);
-		fscanf(fLon, "%lf,\n", MODISLon + i);
-	}
-
-
-	fclose(fLat);
-	fclose(fLon);
-
 	printf("Lat,Lon,Val\n");
 	for(int i = 0; i < nMODIS; i++) {
 		printf("%lf,%lf,%d,%lf\n", MODISLat[i], MODISLon[i], nMISRPixels[i], MODISVal[i]);
@@ -118,27 +103,11 @@ int main(int argc, char ** argv) {
 
 	souNNTarID = (int *) malloc(sizeof(int) * nMODIS);
 	
-	nearestNeighbor(pMISRLat, pMISRLon, nMISR, MODISLat, MODISLon, souNNTarID, nMODIS, maxR);
-	
-	MISRLat = *pMISRLat;
-	MISRLon = *pMISRLon;
+	nearestNeighborConst(ws, MISRLat, MISRLon, nMISR, MODISLat, MODISLon, souNNTarID, nMODIS, maxR);
 	
 	int * nMODISPixels = (int *) malloc(sizeof(int) * nMISR);
 
 	summaryInterpolate(MODISVal, souNNTarID, nMODIS, MISRVal, nMODISPixels, nMISR);
-	
-	fLat = fopen("data/MISR_Latitude-sub", "r");
-	fLon = fopen("data/MISR_Longitude-sub", "r");
-
-	for(int i = 0; i < nMISR; i++) {
-		
-		fscanf(fLat, "%lf,\n", MISRLat + i);
-		fscanf(fLon, "%lf,\n", MISRLon + i);
-	}
-
-
-	fclose(fLat);
-	fclose(fLon);
 
 	printf("Lat,Lon,Count,Val\n");
 	for(int i = 0; i < nMISR; i++) {
@@ -150,11 +119,12 @@ int main(int argc, char ** argv) {
 	//MODIS to MISR
 	
 
-	free(*pMODISLat);
-	free(*pMODISLon);
+	nnWorkspaceFree(ws);
+	free(MODISLat);
+	free(MODISLon);
 	free(MODISVal);
-	free(*pMISRLat);
-	free(*pMISRLon);
+	free(MISRLat);
+	free(MISRLon);
 	free(MISRVal);
 	free(souNNTarID);
 
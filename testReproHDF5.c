@@ -25,33 +25,40 @@ int main(int argc, char ** argv) {
 	int nCellMODIS;
 	int nCellMISR;
 
-	double * MISR_Lat = get_misr_lat(file, "L", &nCellMISR);
-	double * MISR_Lon = get_misr_long(file, "L", &nCellMISR);
+	af_real * MISR_Lat = get_misr_lat(file, "L", &nCellMISR);
+	af_real * MISR_Lon = get_misr_long(file, "L", &nCellMISR);
 
-	double * MISR_Rad;
+	af_real * MISR_Rad;
 
-	double * MODIS_Lat = get_modis_lat(file, "_1KM", "EV_1KM_RefSB", &nCellMODIS); 
-	double * MODIS_Lon = get_modis_long(file, "_1KM", "EV_1KM_RefSB", &nCellMODIS);
+	af_real * MODIS_Lat = get_modis_lat(file, "_1KM", "EV_1KM_RefSB", &nCellMODIS); 
+	af_real * MODIS_Lon = get_modis_long(file, "_1KM", "EV_1KM_RefSB", &nCellMODIS);
 
 	printf("MISR CELLS: %d\n, MODIS CELLS: %d\n", nCellMISR, nCellMODIS);
 
-	double * MODIS_Rad_Out;
+	af_real * MODIS_Rad_Out;
 
 	int * tarNNSouID;
 
 	//MISR TO MODIS NN
 	
-	double ** p_MISR_Lat = &MISR_Lat;
-	double ** p_MISR_Lon = &MISR_Lon;
 
-	tarNNSouID = (int *)malloc(sizeof(int) * nCellMODIS);
+	//The mapping only depends on the two geolocation sets and the radius, reuse it across runs
+	unsigned long long key = nnMappingKey(MISR_Lat, MISR_Lon, nCellMISR, MODIS_Lat, MODIS_Lon, nCellMODIS, 1000);
+	tarNNSouID = af_read_nn_mapping("misr_modis_nn_cache.h5", key, nCellMODIS);
 
 	//Finding nearest points
-	printf("nearest_neighbor\n");
-	nearestNeighbor(p_MISR_Lat, p_MISR_Lon, nCellMISR, MODIS_Lat, MODIS_Lon, tarNNSouID, nCellMODIS, 1000);
+	if(tarNNSouID == NULL) {
+		printf("nearest_neighbor\n");
+		tarNNSouID = (int *)malloc(sizeof(int) * nCellMODIS);
+		nnWorkspace * ws = nnWorkspaceCreate();
+		nearestNeighborConst(ws, MISR_Lat, MISR_Lon, nCellMISR, MODIS_Lat, MODIS_Lon, tarNNSouID, nCellMODIS, 1000);
+		nnWorkspaceFree(ws);
+		af_write_nn_mapping("misr_modis_nn_cache.h5", key, tarNNSouID, nCellMODIS);
+	}
+	else {
+		printf("nearest_neighbor: cached mapping %016llx\n", key);
+	}
 
-	MISR_Lat = * p_MISR_Lat;
-	MISR_Lon = * p_MISR_Lon;
 
 	free(MISR_Lat);
 	free(MISR_Lon);
@@ -66,14 +73,15 @@ int main(int argc, char ** argv) {
 	printf("getting misr\n");
 	MISR_Rad = get_misr_rad(file, "AN", "L", "Blue_Radiance", &nCellMISR);
 	int nCellMODIS_rad;
-	double* MODIS_Rad = get_modis_rad(file, "_1KM", "EV_1KM_RefSB", &nCellMODIS_rad);
+	char* modis_bands[15] = {"8", "9", "10", "11", "12", "13L", "13H", "14L", "14H", "15", "16", "17", "18", "19", "26"};
+	af_real* MODIS_Rad = get_modis_rad(file, "_1KM", modis_bands, 15, &nCellMODIS_rad);
 	
-	MODIS_Rad_Out = (double *)malloc(sizeof(double) * nCellMODIS);
+	MODIS_Rad_Out = (af_real *)malloc(sizeof(af_real) * nCellMODIS);
 	
 	printf("interpolating\n");
 	nnInterpolate(MISR_Rad, MODIS_Rad_Out, tarNNSouID, nCellMODIS);
 	printf("writing data fields\n");
-	int data_write_status = af_write_misr_on_modis(output_file, MODIS_Rad_Out, MODIS_Rad, nCellMODIS_rad, nCellMODIS);
+	int data_write_status = af_write_misr_on_modis(output_file, MODIS_Rad_Out, MODIS_Rad, 15, nCellMODIS_rad, nCellMODIS);
 
 	
 	free(MISR_Rad);